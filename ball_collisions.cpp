@@ -0,0 +1,145 @@
+#include "ball_collisions.h"
+
+#include <algorithm>
+#include <cmath>
+
+BallCollisions::BallCollisions() : target(nullptr), contacts(0) {
+    // Zadania tworzymy raz - std::function z przechwyconym stanem alokowaaby w kadym takcie
+    gatherJob = [this](size_t begin, size_t end) { gatherChunk(*target, begin, end); };
+    partnerJob = [this](size_t begin, size_t end) { partnerChunk(begin, end); };
+    collideJob = [this](size_t begin, size_t end) { collideChunk(begin, end); };
+    applyJob = [this](size_t begin, size_t end) { applyChunk(*target, begin, end); };
+}
+
+// Wywouje fn(t, nx, ny, overlap) dla kadego slotu t, ktrego pika nachodzi na pik w slocie s;
+// (nx, ny) to normalna od t do s
+template<typename Fn>
+void BallCollisions::forEachOverlap(size_t s, Fn fn) const {
+    int32_t cell = grid.cellOfSlot(s);
+    float xs = sx[s], ys = sy[s], rs = sr[s];
+    int cx = cell % grid.cellsX();
+    int cy = cell / grid.cellsX();
+    int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, grid.cellsX() - 1);
+    int y0 = std::max(cy - 1, 0), y1 = std::min(cy + 1, grid.cellsY() - 1);
+    for (int gy = y0; gy <= y1; gy++) {
+        // Komrki jednego wiersza ssiedztwa zajmuj cigy zakres slotw
+        uint32_t end = grid.cellEnd(x1, gy);
+        for (uint32_t t = grid.cellBegin(x0, gy); t < end; t++) {
+            if (t == s) continue;
+            float dx = xs - sx[t];
+            float dy = ys - sy[t];
+            float reach = rs + sr[t];
+            float dist2 = dx * dx + dy * dy;
+            // Piki w tym samym punkcie (np. tu po pojawieniu si) nie maj normalnej
+            if (dist2 >= reach * reach || dist2 == 0.0f) continue;
+            float dist = std::sqrt(dist2);
+            fn(t, dx / dist, dy / dist, reach - dist);
+        }
+    }
+}
+
+void BallCollisions::gatherChunk(const BallStore& store, size_t begin, size_t end) {
+    for (size_t s = begin; s < end; s++) {
+        uint32_t i = grid.ball(s);
+        sx[s] = store.x[i];
+        sy[s] = store.y[i];
+        svx[s] = store.xSpeed[i];
+        svy[s] = store.ySpeed[i];
+        sr[s] = store.radius[i];
+    }
+}
+
+// Partner piki to nachodzca na ni pika, ktra zblia si najszybciej (przy remisie pierwsza)
+void BallCollisions::partnerChunk(size_t begin, size_t end) {
+    for (size_t s = begin; s < end; s++) {
+        int32_t best = -1;
+        float bestSpeed = 0.0f;
+        forEachOverlap(s, [&](size_t t, float nx, float ny, float) {
+            // Skadowa prdkoci wzgldnej wzdu normalnej; ujemna = piki si zbliaj
+            float vn = (svx[s] - svx[t]) * nx + (svy[s] - svy[t]) * ny;
+            if (vn < bestSpeed) {
+                bestSpeed = vn;
+                best = static_cast<int32_t>(t);
+            }
+        });
+        partner[s] = best;
+    }
+}
+
+// Zderzamy tylko pary, w ktrych piki wybray siebie nawzajem - kada pika bierze udzia
+// w co najwyej jednym zderzeniu na takt, wic impulsy liczone ze starych prdkoci s dokadnie
+// spryste (zachowuj pd i energi) i nie sumuj si w gstych skupiskach.
+// Pozostae zbliajce si pary zderz si w kolejnych taktach.
+// Kady slot pisze tylko swoje dane, wic wynik nie zaley od podziau na porcje.
+void BallCollisions::collideChunk(size_t begin, size_t end) {
+    size_t pairs = 0;
+    for (size_t s = begin; s < end; s++) {
+        float ms = sr[s] * sr[s];   // Masa proporcjonalna do pola koa
+        float ax = 0.0f, ay = 0.0f, px = 0.0f, py = 0.0f;
+        int overlaps = 0;
+        int32_t p = partner[s];
+        bool mutual = p >= 0 && partner[p] == static_cast<int32_t>(s);
+        forEachOverlap(s, [&](size_t t, float nx, float ny, float overlap) {
+            float mt = sr[t] * sr[t];
+            float share = mt / (ms + mt);
+
+            // Rozsunicie - pika przesuwa si o swoj cz zachodzenia
+            px += overlap * share * nx;
+            py += overlap * share * ny;
+            overlaps++;
+
+            if (mutual && static_cast<int32_t>(t) == p) {
+                float vn = (svx[s] - svx[t]) * nx + (svy[s] - svy[t]) * ny;
+                ax = -2.0f * share * vn * nx;
+                ay = -2.0f * share * vn * ny;
+            }
+        });
+        dvx[s] = ax;
+        dvy[s] = ay;
+        // Rozsunicia uredniamy, eby pika cinita z kilku stron nie wyskakiwaa
+        dpx[s] = overlaps ? px / overlaps : 0.0f;
+        dpy[s] = overlaps ? py / overlaps : 0.0f;
+        if (mutual) pairs++;
+    }
+    contacts.fetch_add(pairs, std::memory_order_relaxed);
+}
+
+// Rozsunita pika nie moe wyj za cian - kernel odwracaby jej prdko w kadym takcie
+void BallCollisions::applyChunk(BallStore& store, size_t begin, size_t end) {
+    for (size_t s = begin; s < end; s++) {
+        uint32_t i = grid.ball(s);
+        store.xSpeed[i] += dvx[s];
+        store.ySpeed[i] += dvy[s];
+        if (dpx[s] != 0.0f || dpy[s] != 0.0f) {
+            float limit = 1.0f - sr[s];
+            store.x[i] = std::min(std::max(sx[s] + dpx[s], -limit), limit);
+            store.y[i] = std::min(std::max(sy[s] + dpy[s], -limit), limit);
+        }
+    }
+}
+
+size_t BallCollisions::resolve(BallStore& store, float maxRadius, WorkerPool& pool) {
+    if (store.awakeCount() < 2) return 0;
+    grid.build(store, 2.0f * maxRadius, pool);
+    size_t n = grid.count();
+    sx.resize(n);
+    sy.resize(n);
+    svx.resize(n);
+    svy.resize(n);
+    sr.resize(n);
+    partner.resize(n);
+    dvx.resize(n);
+    dvy.resize(n);
+    dpx.resize(n);
+    dpy.resize(n);
+
+    target = &store;
+    contacts.store(0, std::memory_order_relaxed);
+    pool.parallelFor(n, gatherJob, "collisions: gather");
+    pool.parallelFor(n, partnerJob, "collisions: partner");
+    pool.parallelFor(n, collideJob, "collisions: collide");
+    pool.parallelFor(n, applyJob, "collisions: apply");
+    target = nullptr;
+    // Kada para zostaa policzona przez obie piki
+    return contacts.load() / 2;
+}
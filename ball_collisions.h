@@ -0,0 +1,48 @@
+#ifndef BALL_COLLISIONS_H
+#define BALL_COLLISIONS_H
+
+#include <atomic>
+
+#include "ball_store.h"
+#include "uniform_grid.h"
+#include "worker_pool.h"
+
+// Spryste zderzenia pika-pika. Faza szeroka to UniformGrid przebudowywana co takt,
+// faza wska sprawdza tylko ssiedztwo 3x3 komrki piki, wic koszt ronie liniowo z liczb piek.
+class BallCollisions {
+public:
+    BallCollisions();
+
+    // Rozwizuje zderzenia ruchomych piek o promieniu nie wikszym ni maxRadius.
+    // Zwraca liczb par, ktre si zderzyy.
+    size_t resolve(BallStore& store, float maxRadius, WorkerPool& pool);
+
+private:
+    template<typename Fn>
+    void forEachOverlap(size_t s, Fn fn) const;
+
+    // Kopiuje stan piek do tablic w kolejnoci slotw siatki
+    void gatherChunk(const BallStore& store, size_t begin, size_t end);
+
+    // Wybiera partnera zderzenia dla slotw [begin, end)
+    void partnerChunk(size_t begin, size_t end);
+
+    // Liczy zmian prdkoci i pozycji slotw [begin, end)
+    void collideChunk(size_t begin, size_t end);
+
+    // Dodaje zmiany do magazynu piek
+    void applyChunk(BallStore& store, size_t begin, size_t end);
+
+    UniformGrid grid;
+    BallStore* target;
+    WorkerPool::Job gatherJob, partnerJob, collideJob, applyJob;
+    std::atomic<size_t> contacts;
+
+    // Stan piek w kolejnoci slotw
+    FloatArray sx, sy, svx, svy, sr;
+    IntArray partner;      // Slot partnera zderzenia w tym takcie lub -1
+    FloatArray dvx, dvy;   // Zmiana prdkoci w tym takcie
+    FloatArray dpx, dpy;   // Rozsunicie nachodzcych na siebie piek
+};
+
+#endif
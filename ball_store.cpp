@@ -0,0 +1,442 @@
+#include "ball_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BallStore::BallStore(size_t capacity) : cap(capacity), numAwake(0), numRetired(0), firstRetired(0) {
+    x.reserve(cap); y.reserve(cap);
+    prevX.reserve(cap); prevY.reserve(cap);
+    xSpeed.reserve(cap); ySpeed.reserve(cap);
+    radius.reserve(cap);
+    numBounces.reserve(cap);
+    moving.reserve(cap);
+    events.reserve(cap);
+    colorR.reserve(cap); colorG.reserve(cap); colorB.reserve(cap);
+    active.reserve(cap);
+    attached.reserve(cap);
+    cooldownEnd.reserve(cap);
+    serial.reserve(cap);
+    slotOf.reserve(cap);
+    slotIndex.reserve(cap);
+    slotGeneration.reserve(cap);
+    freeSlots.reserve(cap);
+}
+
+// Metoda tworzca now pik
+BallHandle BallStore::spawn(float r, float px, float py, uint64_t id, const float rnd[5]) {
+    if (size() >= cap) return INVALID_BALL;
+
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slotIndex.size());
+        slotIndex.push_back(SIZE_MAX);
+        slotGeneration.push_back(0);
+    }
+    slotIndex[slot] = size();
+    slotOf.push_back(slot);
+
+    radius.push_back(r);
+    x.push_back(px);
+    y.push_back(py);
+    prevX.push_back(x.back());
+    prevY.push_back(y.back());
+    xSpeed.push_back(rnd[0] * 0.24f - 0.12f);
+    ySpeed.push_back(rnd[1] * 0.16f - 0.08f);
+    colorR.push_back(rnd[2]);
+    colorG.push_back(rnd[3]);
+    colorB.push_back(rnd[4]);
+    numBounces.push_back(0);
+    moving.push_back(1);
+    numAwake++;
+    events.push_back(0);
+    active.push_back(1);
+    attached.push_back(0);
+    cooldownEnd.push_back(-std::numeric_limits<double>::infinity());
+    serial.push_back(id);
+    return handle(size() - 1);
+}
+
+// Pika przestaje si porusza (przyklejona), ale zostaje w magazynie
+void BallStore::sleep(size_t i) {
+    if (!moving[i]) return;
+    moving[i] = 0;
+    numAwake--;
+}
+
+// Pika znw si porusza; usunitej nie da si obudzi
+void BallStore::wake(size_t i) {
+    if (moving[i] || !active[i]) return;
+    moving[i] = 1;
+    numAwake++;
+}
+
+// Oznacza pik do usunicia; znika z magazynu przy najbliszym compact()
+void BallStore::retire(size_t i) {
+    if (!active[i]) return;
+    sleep(i);
+    active[i] = 0;
+    firstRetired = numRetired == 0 ? i : std::min(firstRetired, i);
+    numRetired++;
+}
+
+// Usuwa nieaktywne piki zachowujc kolejno
+bool BallStore::compact() {
+    if (numRetired == 0) return false;
+    size_t n = size();
+    size_t out = firstRetired;
+    for (size_t i = firstRetired; i < n; i++) {
+        if (!active[i]) {
+            // Nowa generacja uniewania wszystkie uchwyty do tej piki
+            uint32_t slot = slotOf[i];
+            slotIndex[slot] = SIZE_MAX;
+            slotGeneration[slot]++;
+            freeSlots.push_back(slot);
+            continue;
+        }
+        if (out != i) move(i, out);
+        out++;
+    }
+    numRetired = 0;
+    resize(out);
+    return true;
+}
+
+void BallStore::move(size_t from, size_t to) {
+    x[to] = x[from]; y[to] = y[from];
+    prevX[to] = prevX[from]; prevY[to] = prevY[from];
+    xSpeed[to] = xSpeed[from]; ySpeed[to] = ySpeed[from];
+    radius[to] = radius[from];
+    numBounces[to] = numBounces[from];
+    moving[to] = moving[from];
+    events[to] = events[from];
+    colorR[to] = colorR[from]; colorG[to] = colorG[from]; colorB[to] = colorB[from];
+    active[to] = active[from];
+    attached[to] = attached[from];
+    cooldownEnd[to] = cooldownEnd[from];
+    serial[to] = serial[from];
+    slotOf[to] = slotOf[from];
+    slotIndex[slotOf[to]] = to;
+}
+
+void BallStore::resize(size_t n) {
+    x.resize(n); y.resize(n);
+    prevX.resize(n); prevY.resize(n);
+    xSpeed.resize(n); ySpeed.resize(n);
+    radius.resize(n);
+    numBounces.resize(n);
+    moving.resize(n);
+    events.resize(n);
+    colorR.resize(n); colorG.resize(n); colorB.resize(n);
+    active.resize(n);
+    attached.resize(n);
+    cooldownEnd.resize(n);
+    serial.resize(n);
+    slotOf.resize(n);
+}
+
+void BallStore::save(CheckpointWriter& out) const {
+    out.write("BALX", x); out.write("BALY", y);
+    out.write("BPVX", prevX); out.write("BPVY", prevY);
+    out.write("BVLX", xSpeed); out.write("BVLY", ySpeed);
+    out.write("BRAD", radius);
+    out.write("BBNC", numBounces);
+    out.write("BMOV", moving);
+    out.write("BEVT", events);
+    out.write("BCLR", colorR); out.write("BCLG", colorG); out.write("BCLB", colorB);
+    out.write("BACT", active);
+    out.write("BATT", attached);
+    out.write("BCDN", cooldownEnd);
+    out.write("BSER", serial);
+    out.write("SOF ", slotOf);
+    out.write("SIDX", slotIndex);
+    out.write("SGEN", slotGeneration);
+    out.write("SFRE", freeSlots);
+}
+
+bool BallStore::load(CheckpointReader& in) {
+    bool ok = in.read("BALX", x) && in.read("BALY", y) &&
+              in.read("BPVX", prevX) && in.read("BPVY", prevY) &&
+              in.read("BVLX", xSpeed) && in.read("BVLY", ySpeed) &&
+              in.read("BRAD", radius) &&
+              in.read("BBNC", numBounces) &&
+              in.read("BMOV", moving) &&
+              in.read("BEVT", events) &&
+              in.read("BCLR", colorR) && in.read("BCLG", colorG) && in.read("BCLB", colorB) &&
+              in.read("BACT", active) &&
+              in.read("BATT", attached) &&
+              in.read("BCDN", cooldownEnd) &&
+              in.read("BSER", serial) &&
+              in.read("SOF ", slotOf) &&
+              in.read("SIDX", slotIndex) &&
+              in.read("SGEN", slotGeneration) &&
+              in.read("SFRE", freeSlots);
+    if (!ok) return false;
+
+    // Wszystkie tablice piek musz mie t sam dugo, a sloty musz wskazywa na siebie nawzajem
+    size_t n = x.size();
+    // Kady slot jest zajty przez jedn pik albo wolny, wic slotw jest tyle, ile piek i wolnych slotw
+    if (n > cap || slotIndex.size() > cap || slotGeneration.size() != slotIndex.size() ||
+        slotIndex.size() != n + freeSlots.size()) {
+        return false;
+    }
+    const size_t sizes[] = { y.size(), prevX.size(), prevY.size(), xSpeed.size(), ySpeed.size(), radius.size(),
+                             numBounces.size(), moving.size(), events.size(), colorR.size(), colorG.size(),
+                             colorB.size(), active.size(), attached.size(), cooldownEnd.size(), serial.size(),
+                             slotOf.size() };
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        if (sizes[k] != n) return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (slotOf[i] >= slotIndex.size() || slotIndex[slotOf[i]] != i) return false;
+    }
+    for (size_t k = 0; k < slotIndex.size(); k++) {
+        if (slotIndex[k] != SIZE_MAX && (slotIndex[k] >= n || slotOf[slotIndex[k]] != k)) return false;
+    }
+    // Wolny slot wystpuje na licie dokadnie raz, inaczej dwie nowe piki dostayby ten sam
+    std::vector<uint8_t> listed(slotIndex.size(), 0);
+    for (size_t k = 0; k < freeSlots.size(); k++) {
+        if (freeSlots[k] >= slotIndex.size() || slotIndex[freeSlots[k]] != SIZE_MAX || listed[freeSlots[k]]) {
+            return false;
+        }
+        listed[freeSlots[k]] = 1;
+    }
+
+    // Liczniki stanw nie s zapisywane - odtwarzamy je z flag
+    numAwake = 0;
+    numRetired = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!active[i]) {
+            moving[i] = 0;
+            if (numRetired++ == 0) firstRetired = i;
+        } else if (moving[i]) {
+            numAwake++;
+        }
+    }
+    return true;
+}
+
+void stepKernelScalar(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step) {
+    for (size_t i = begin; i < end; i++) {
+        int32_t ev = 0;
+        if (store.moving[i]) {
+            if (store.numBounces[i] < bounceLimit) {
+                float r = store.radius[i];
+                float hi = 1.0f - r;   // ciany s symetryczne: -hi i hi
+                float x0 = store.x[i];
+                float y0 = store.y[i];
+                float vx = store.xSpeed[i];
+                float vy = store.ySpeed[i];
+                float xe = x0 + vx * step;
+                float ye = y0 + vy * step;
+                float x = xe;
+                float y = ye;
+                // Zwrot prdkoci wybiera cian; mnoenie przez +-1 jest dokadne jak zmiana znaku w SIMD
+                float sx = std::copysign(1.0f, vx);
+                float sy = std::copysign(1.0f, vy);
+                if (xe * sx > hi) {
+                    x = 2.0f * (hi * sx) - xe;
+                    store.xSpeed[i] = -vx;
+                    store.numBounces[i]++;
+                    ev |= EVENT_BOUNCE_X;
+                }
+                if (ye * sy > hi) {
+                    y = 2.0f * (hi * sy) - ye;
+                    store.ySpeed[i] = -vy;
+                    store.numBounces[i]++;
+                    ev |= EVENT_BOUNCE_Y;
+                }
+                store.x[i] = x;
+                store.y[i] = y;
+                // Po odbiciu pika wraca od ciany do (x, y), wic prostokt musi obj x0, xe i x (oraz y)
+                float minX = std::min(std::min(x0, xe), x);
+                float maxX = std::max(std::max(x0, xe), x);
+                float minY = std::min(std::min(y0, ye), y);
+                float maxY = std::max(std::max(y0, ye), y);
+                if ((maxX + r > obs.x && minX - r < obs.x + obs.width &&
+                     maxY + r > obs.y && minY - r < obs.y + obs.height) ||
+                    std::max(std::fabs(x), std::fabs(y)) > hi) {
+                    ev |= EVENT_SWEEP;
+                }
+            } else {
+                ev = EVENT_EXPIRED;
+            }
+        }
+        store.events[i] = ev;
+    }
+}
+
+#ifdef BALLS_X86_SIMD
+void stepKernelSse(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step) {
+    const __m128 stepV = _mm_set1_ps(step);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 obsMinX = _mm_set1_ps(obs.x);
+    const __m128 obsMaxX = _mm_set1_ps(obs.x + obs.width);
+    const __m128 obsMinY = _mm_set1_ps(obs.y);
+    const __m128 obsMaxY = _mm_set1_ps(obs.y + obs.height);
+    const __m128i limit = _mm_set1_epi32(bounceLimit);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sweepFlag = _mm_set1_epi32(EVENT_SWEEP);
+    const __m128i expiredFlag = _mm_set1_epi32(EVENT_EXPIRED);
+    const __m128i bounceXFlag = _mm_set1_epi32(EVENT_BOUNCE_X);
+    const __m128i bounceYFlag = _mm_set1_epi32(EVENT_BOUNCE_Y);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i mov = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&store.moving[i])), zero);
+        __m128i bounces = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&store.numBounces[i]));
+        __m128i live = _mm_and_si128(mov, _mm_cmplt_epi32(bounces, limit));
+        __m128 liveF = _mm_castsi128_ps(live);
+
+        __m128 r = _mm_loadu_ps(&store.radius[i]);
+        __m128 hi = _mm_sub_ps(one, r);
+        __m128 vx = _mm_loadu_ps(&store.xSpeed[i]);
+        __m128 vy = _mm_loadu_ps(&store.ySpeed[i]);
+        __m128 x0 = _mm_loadu_ps(&store.x[i]);
+        __m128 y0 = _mm_loadu_ps(&store.y[i]);
+        __m128 xe = _mm_add_ps(x0, _mm_mul_ps(vx, stepV));
+        __m128 ye = _mm_add_ps(y0, _mm_mul_ps(vy, stepV));
+
+        // Odbicie lustrzane wzgldem ciany, w stron ktrej pika leci
+        __m128 sx = _mm_and_ps(vx, signBit);
+        __m128 sy = _mm_and_ps(vy, signBit);
+        __m128 hitX = _mm_and_ps(liveF, _mm_cmpgt_ps(_mm_xor_ps(xe, sx), hi));
+        __m128 hitY = _mm_and_ps(liveF, _mm_cmpgt_ps(_mm_xor_ps(ye, sy), hi));
+        __m128 wallX = _mm_xor_ps(hi, sx);
+        __m128 wallY = _mm_xor_ps(hi, sy);
+        __m128 x = _mm_or_ps(_mm_and_ps(hitX, _mm_sub_ps(_mm_add_ps(wallX, wallX), xe)), _mm_andnot_ps(hitX, xe));
+        __m128 y = _mm_or_ps(_mm_and_ps(hitY, _mm_sub_ps(_mm_add_ps(wallY, wallY), ye)), _mm_andnot_ps(hitY, ye));
+        vx = _mm_xor_ps(vx, _mm_and_ps(hitX, signBit));
+        vy = _mm_xor_ps(vy, _mm_and_ps(hitY, signBit));
+        bounces = _mm_sub_epi32(bounces, _mm_castps_si128(hitX));
+        bounces = _mm_sub_epi32(bounces, _mm_castps_si128(hitY));
+
+        x = _mm_or_ps(_mm_and_ps(liveF, x), _mm_andnot_ps(liveF, x0));
+        y = _mm_or_ps(_mm_and_ps(liveF, y), _mm_andnot_ps(liveF, y0));
+
+        // Prostokt drogi z odbiciem: x0, xe i x po odbiciu (jak w wersji skalarnej)
+        __m128 minX = _mm_min_ps(_mm_min_ps(x0, xe), x);
+        __m128 maxX = _mm_max_ps(_mm_max_ps(x0, xe), x);
+        __m128 minY = _mm_min_ps(_mm_min_ps(y0, ye), y);
+        __m128 maxY = _mm_max_ps(_mm_max_ps(y0, ye), y);
+        __m128 overlap = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(maxX, r), obsMinX),
+                                               _mm_cmplt_ps(_mm_sub_ps(minX, r), obsMaxX)),
+                                    _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(maxY, r), obsMinY),
+                                               _mm_cmplt_ps(_mm_sub_ps(minY, r), obsMaxY)));
+        __m128 outside = _mm_cmpgt_ps(_mm_max_ps(_mm_andnot_ps(signBit, x), _mm_andnot_ps(signBit, y)), hi);
+        __m128i ev = _mm_and_si128(_mm_castps_si128(_mm_and_ps(_mm_or_ps(overlap, outside), liveF)), sweepFlag);
+        ev = _mm_or_si128(ev, _mm_and_si128(_mm_castps_si128(hitX), bounceXFlag));
+        ev = _mm_or_si128(ev, _mm_and_si128(_mm_castps_si128(hitY), bounceYFlag));
+        ev = _mm_or_si128(ev, _mm_and_si128(_mm_andnot_si128(live, mov), expiredFlag));
+
+        _mm_storeu_ps(&store.x[i], x);
+        _mm_storeu_ps(&store.y[i], y);
+        _mm_storeu_ps(&store.xSpeed[i], vx);
+        _mm_storeu_ps(&store.ySpeed[i], vy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&store.numBounces[i]), bounces);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&store.events[i]), ev);
+    }
+    stepKernelScalar(store, i, end, obs, bounceLimit, step);
+}
+
+__attribute__((target("avx2")))
+void stepKernelAvx2(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step) {
+    const __m256 stepV = _mm256_set1_ps(step);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 obsMinX = _mm256_set1_ps(obs.x);
+    const __m256 obsMaxX = _mm256_set1_ps(obs.x + obs.width);
+    const __m256 obsMinY = _mm256_set1_ps(obs.y);
+    const __m256 obsMaxY = _mm256_set1_ps(obs.y + obs.height);
+    const __m256i limit = _mm256_set1_epi32(bounceLimit);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i sweepFlag = _mm256_set1_epi32(EVENT_SWEEP);
+    const __m256i expiredFlag = _mm256_set1_epi32(EVENT_EXPIRED);
+    const __m256i bounceXFlag = _mm256_set1_epi32(EVENT_BOUNCE_X);
+    const __m256i bounceYFlag = _mm256_set1_epi32(EVENT_BOUNCE_Y);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i mov = _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&store.moving[i])), zero);
+        __m256i bounces = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&store.numBounces[i]));
+        __m256i live = _mm256_and_si256(mov, _mm256_cmpgt_epi32(limit, bounces));
+        __m256 liveF = _mm256_castsi256_ps(live);
+
+        __m256 r = _mm256_loadu_ps(&store.radius[i]);
+        __m256 hi = _mm256_sub_ps(one, r);
+        __m256 vx = _mm256_loadu_ps(&store.xSpeed[i]);
+        __m256 vy = _mm256_loadu_ps(&store.ySpeed[i]);
+        __m256 x0 = _mm256_loadu_ps(&store.x[i]);
+        __m256 y0 = _mm256_loadu_ps(&store.y[i]);
+        __m256 xe = _mm256_add_ps(x0, _mm256_mul_ps(vx, stepV));
+        __m256 ye = _mm256_add_ps(y0, _mm256_mul_ps(vy, stepV));
+
+        // Odbicie lustrzane wzgldem ciany, w stron ktrej pika leci
+        __m256 sx = _mm256_and_ps(vx, signBit);
+        __m256 sy = _mm256_and_ps(vy, signBit);
+        __m256 hitX = _mm256_and_ps(liveF, _mm256_cmp_ps(_mm256_xor_ps(xe, sx), hi, _CMP_GT_OQ));
+        __m256 hitY = _mm256_and_ps(liveF, _mm256_cmp_ps(_mm256_xor_ps(ye, sy), hi, _CMP_GT_OQ));
+        __m256 wallX = _mm256_xor_ps(hi, sx);
+        __m256 wallY = _mm256_xor_ps(hi, sy);
+        __m256 x = _mm256_blendv_ps(xe, _mm256_sub_ps(_mm256_add_ps(wallX, wallX), xe), hitX);
+        __m256 y = _mm256_blendv_ps(ye, _mm256_sub_ps(_mm256_add_ps(wallY, wallY), ye), hitY);
+        vx = _mm256_xor_ps(vx, _mm256_and_ps(hitX, signBit));
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(hitY, signBit));
+        bounces = _mm256_sub_epi32(bounces, _mm256_castps_si256(hitX));
+        bounces = _mm256_sub_epi32(bounces, _mm256_castps_si256(hitY));
+
+        x = _mm256_blendv_ps(x0, x, liveF);
+        y = _mm256_blendv_ps(y0, y, liveF);
+
+        // Prostokt drogi z odbiciem: x0, xe i x po odbiciu (jak w wersji skalarnej)
+        __m256 minX = _mm256_min_ps(_mm256_min_ps(x0, xe), x);
+        __m256 maxX = _mm256_max_ps(_mm256_max_ps(x0, xe), x);
+        __m256 minY = _mm256_min_ps(_mm256_min_ps(y0, ye), y);
+        __m256 maxY = _mm256_max_ps(_mm256_max_ps(y0, ye), y);
+        __m256 overlap = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(maxX, r), obsMinX, _CMP_GT_OQ),
+                          _mm256_cmp_ps(_mm256_sub_ps(minX, r), obsMaxX, _CMP_LT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(maxY, r), obsMinY, _CMP_GT_OQ),
+                          _mm256_cmp_ps(_mm256_sub_ps(minY, r), obsMaxY, _CMP_LT_OQ)));
+        __m256 outside = _mm256_cmp_ps(_mm256_max_ps(_mm256_andnot_ps(signBit, x), _mm256_andnot_ps(signBit, y)), hi,
+                                       _CMP_GT_OQ);
+        __m256i ev = _mm256_and_si256(_mm256_castps_si256(_mm256_and_ps(_mm256_or_ps(overlap, outside), liveF)),
+                                      sweepFlag);
+        ev = _mm256_or_si256(ev, _mm256_and_si256(_mm256_castps_si256(hitX), bounceXFlag));
+        ev = _mm256_or_si256(ev, _mm256_and_si256(_mm256_castps_si256(hitY), bounceYFlag));
+        ev = _mm256_or_si256(ev, _mm256_and_si256(_mm256_andnot_si256(live, mov), expiredFlag));
+
+        _mm256_storeu_ps(&store.x[i], x);
+        _mm256_storeu_ps(&store.y[i], y);
+        _mm256_storeu_ps(&store.xSpeed[i], vx);
+        _mm256_storeu_ps(&store.ySpeed[i], vy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&store.numBounces[i]), bounces);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&store.events[i]), ev);
+    }
+    stepKernelScalar(store, i, end, obs, bounceLimit, step);
+}
+#endif
+
+// Wybr kernela na podstawie moliwoci procesora (raz, przy starcie)
+static StepKernel selectStepKernel() {
+#ifdef BALLS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return stepKernelAvx2;
+    if (__builtin_cpu_supports("sse2")) return stepKernelSse;
+#endif
+    return stepKernelScalar;
+}
+
+StepKernel stepKernel = selectStepKernel();
+
+const char* stepKernelName() {
+#ifdef BALLS_X86_SIMD
+    if (stepKernel == stepKernelAvx2) return "avx2";
+    if (stepKernel == stepKernelSse) return "sse2";
+#endif
+    return "scalar";
+}
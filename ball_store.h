@@ -0,0 +1,174 @@
+#ifndef BALL_STORE_H
+#define BALL_STORE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+#include "checkpoint.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BALLS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Alokator wyrwnujcy tablice do 32 bajtw (szeroko rejestru AVX)
+template<typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+    static const size_t alignment = 32;
+
+    AlignedAllocator() {}
+    template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+#ifdef BALLS_X86_SIMD
+        void* p = _mm_malloc(n * sizeof(T), alignment);
+#else
+        void* p = std::malloc(n * sizeof(T));
+#endif
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t) {
+#ifdef BALLS_X86_SIMD
+        _mm_free(p);
+#else
+        std::free(p);
+#endif
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+typedef std::vector<float, AlignedAllocator<float>> FloatArray;
+typedef std::vector<int32_t, AlignedAllocator<int32_t>> IntArray;
+
+// Flagi zdarze zwracane przez kernel dla kadej piki
+enum BallEvent {
+    EVENT_SWEEP = 1,      // Droga piki przecina prostokt obejmujcy wszystkie GrayObs albo siga
+                          // za cian mimo odbicia - takt trzeba policzy dokadnie (Simulation::sweepBall)
+    EVENT_EXPIRED = 2,    // Pika przekroczya limit odbi i powinna znikn
+    EVENT_BOUNCE_X = 4,   // Kernel odbi pik od lewej lub prawej ciany
+    EVENT_BOUNCE_Y = 8    // Kernel odbi pik od dolnej lub grnej ciany
+};
+
+// Uchwyt piki - pozostaje wany mimo przesuwania piek przy kompaktowaniu magazynu.
+// Slot jest uywany ponownie po znikniciu piki, a generacja odrnia now pik od starej,
+// wic nieaktualny uchwyt zostaje wykryty zamiast wskazywa na inn pik.
+struct BallHandle {
+    uint32_t slot;
+    uint32_t generation;
+
+    bool valid() const { return slot != UINT32_MAX; }
+};
+
+const BallHandle INVALID_BALL = { UINT32_MAX, 0 };
+
+// Magazyn piek w ukadzie struktury tablic - pola gorce w cigych, wyrwnanych tablicach.
+// Pojemno jest staa: wszystkie tablice s rezerwowane w konstruktorze, wic tworzenie
+// i usuwanie piek nie alokuje pamici.
+class BallStore {
+public:
+    explicit BallStore(size_t capacity);
+
+    // Pola gorce, czytane w kadym takcie
+    FloatArray x, y;
+    FloatArray prevX, prevY;   // Pozycja z pocztku ostatniego taktu, do interpolacji przy rysowaniu
+    FloatArray xSpeed, ySpeed;
+    FloatArray radius;
+    IntArray numBounces;
+    IntArray moving;   // 1 dla piek aktywnych i nieprzyklejonych; zmienia przez sleep(), wake() i retire()
+    IntArray events;   // Wynik kernela z ostatniego taktu (BallEvent)
+
+    // Pola zimne, potrzebne przy rysowaniu i przyklejaniu
+    std::vector<float> colorR, colorG, colorB;
+    std::vector<uint8_t> active;
+    std::vector<uint8_t> attached;
+    std::vector<double> cooldownEnd;   // Czas symulacji (s), do ktrego pika nie moe si przyklei
+    std::vector<uint64_t> serial;      // Numer kolejny piki - identyfikator w generatorze liczb losowych
+
+    size_t size() const { return x.size(); }
+    size_t capacity() const { return cap; }
+
+    // Metoda tworzca now pik o promieniu r w punkcie (px, py); rnd to pi liczb z [0, 1)
+    // na prdko i kolor. Zwraca INVALID_BALL, gdy magazyn jest peny
+    BallHandle spawn(float r, float px, float py, uint64_t id, const float rnd[5]);
+
+    // Uchwyt piki o indeksie i
+    BallHandle handle(size_t i) const {
+        BallHandle h = { slotOf[i], slotGeneration[slotOf[i]] };
+        return h;
+    }
+
+    // Biecy indeks piki albo SIZE_MAX, jeli pika ju znikna
+    size_t indexOf(BallHandle h) const {
+        if (h.slot >= slotIndex.size() || slotGeneration[h.slot] != h.generation) return SIZE_MAX;
+        return slotIndex[h.slot];
+    }
+
+    // Stan piki: obudzona (moving - porusza j takt), upiona (przyklejona - pozycj ustawia GrayObs)
+    // albo usunita (czeka na compact()). Zmiany stanu przechodz przez te metody, wic magazyn zna
+    // liczb piek w kadym stanie i takt nie musi ich szuka. Woa tylko z wtku symulacji.
+    void sleep(size_t i);
+    void wake(size_t i);
+    void retire(size_t i);
+    size_t awakeCount() const { return numAwake; }
+    size_t retiredCount() const { return numRetired; }
+
+    // Usuwa piki oznaczone przez retire() zachowujc kolejno, zwalnia ich sloty; zwraca true,
+    // jeli co usunito. Przeglda tylko piki od pierwszej usunitej, bez usunitych nic nie robi
+    bool compact();
+
+    // Zapis i odczyt wszystkich tablic razem z tablicami slotw, wic uchwyty zachowuj wano.
+    // load() wymaga magazynu o pojemnoci nie mniejszej ni zapisana liczba piek i slotw
+    void save(CheckpointWriter& out) const;
+    bool load(CheckpointReader& in);
+
+private:
+    void move(size_t from, size_t to);
+    void resize(size_t n);
+
+    size_t cap;
+    size_t numAwake;
+    size_t numRetired;
+    size_t firstRetired;                    // Najmniejszy indeks usunitej piki (gdy numRetired > 0)
+    std::vector<uint32_t> slotOf;           // Slot piki o danym indeksie
+    std::vector<size_t> slotIndex;          // Indeks piki w danym slocie lub SIZE_MAX
+    std::vector<uint32_t> slotGeneration;   // Zwikszana przy zwolnieniu slotu
+    std::vector<uint32_t> freeSlots;        // Zwolnione sloty, uywane od ostatniego
+};
+
+// Prostokt GrayObs
+struct ObsRect {
+    float x, y, width, height;
+};
+
+// Kernel taktu: cakowanie (przesunicie o prdko * step), odbicie od cian, licznik odbi
+// i test AABB drogi piki w tym takcie z prostoktem obejmujcym wszystkie GrayObs.
+// Odbicie jest dokadne: pika, ktra przekroczyaby cian, zostaje odbita lustrzanie wzgldem niej,
+// tak jakby zawrcia w chwili kontaktu. Odbija si tylko pika lecca na zewntrz, wic nie zawraca
+// dwa razy przy tej samej cianie.
+// Wszystkie warianty daj bitowo ten sam wynik co wersja skalarna.
+typedef void (*StepKernel)(BallStore& store, size_t begin, size_t end, const ObsRect& obs,
+                           int bounceLimit, float step);
+
+void stepKernelScalar(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step);
+#ifdef BALLS_X86_SIMD
+void stepKernelSse(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step);
+void stepKernelAvx2(BallStore& store, size_t begin, size_t end, const ObsRect& obs, int bounceLimit, float step);
+#endif
+
+// Kernel wybrany przy starcie na podstawie moliwoci procesora
+extern StepKernel stepKernel;
+
+// Nazwa wybranego kernela ("avx2", "sse2" albo "scalar")
+const char* stepKernelName();
+
+#endif
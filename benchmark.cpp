@@ -0,0 +1,274 @@
+#include "simulation.h"
+#include "random.h"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+// Licznik alokacji - zastpujemy globalny operator new, eby policzy alokacje na takt
+static std::atomic<unsigned long long> allocCount(0);
+
+void* operator new(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+// Wynik jednego punktu pomiarowego
+struct BenchResult {
+    size_t balls;
+    unsigned workers;
+    unsigned obstacles;
+    unsigned collisions;
+    unsigned long ticks;
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+    double nsPerBall;
+    double allocsPerTick;
+};
+
+// Parametry przebiegu
+struct BenchOptions {
+    std::vector<size_t> ballCounts;
+    std::vector<unsigned> workerCounts;
+    std::vector<unsigned> obstacleCounts;
+    std::vector<unsigned> collisionModes;   // 0 = bez zderze piek, 1 = ze zderzeniami
+    float radius;
+    unsigned long minTicks;
+    unsigned long maxTicks;
+    double targetSeconds;
+    int bounceLimit;
+    const char* outPath;
+};
+
+// Warto percentyla z posortowanej tablicy czasw
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// Mierzy czas Simulation::step dla jednej konfiguracji
+static BenchResult runCase(const BenchOptions& opt, size_t numBalls, unsigned numWorkers, unsigned numObstacles,
+                           unsigned collisions) {
+    SimulationConfig config;
+    config.bounceLimit = opt.bounceLimit;
+    config.numWorkers = numWorkers;
+    config.adaptiveWorkers = false;
+    config.numObstacles = numObstacles;
+    config.ballCollisions = collisions != 0;
+    config.ballRadius = opt.radius;
+    config.seed = 1;
+    config.ballCapacity = numBalls;
+    Simulation sim(config);
+    // Piki rozrzucone po caym ekranie - inaczej wszystkie zaczynaj w jednym punkcie
+    // i zderzenia sprawdzayby kad par
+    std::vector<float> rnd(2 * numBalls);
+    sim.random().fill(STREAM_SCATTER, 0, rnd.data(), rnd.size());
+    float span = 1.0f - opt.radius;
+    for (size_t i = 0; i < numBalls; i++) {
+        sim.spawnBallAt((rnd[2 * i] * 2.0f - 1.0f) * span, (rnd[2 * i + 1] * 2.0f - 1.0f) * span);
+    }
+
+    // Rozgrzewka - pierwsze takty wypeniaj pami podrczn i bufory
+    for (int i = 0; i < 10; i++) {
+        sim.step(BASE_TICK);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(opt.maxTicks);
+    unsigned long long allocsBefore = allocCount.load();
+    double total = 0.0;
+    while (samples.size() < opt.maxTicks && (samples.size() < opt.minTicks || total < opt.targetSeconds)) {
+        auto start = std::chrono::steady_clock::now();
+        sim.step(BASE_TICK);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        samples.push_back(ns);
+        total += ns * 1e-9;
+    }
+    // Alokacja bufora samples nastpia przed pomiarem, wic si nie liczy
+    unsigned long long allocs = allocCount.load() - allocsBefore;
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    BenchResult result;
+    result.balls = numBalls;
+    result.workers = sim.numWorkers();
+    result.obstacles = numObstacles;
+    result.collisions = collisions;
+    result.ticks = static_cast<unsigned long>(samples.size());
+    result.medianNs = percentile(sorted, 0.5);
+    result.p99Ns = percentile(sorted, 0.99);
+    result.meanNs = total * 1e9 / samples.size();
+    result.nsPerBall = numBalls ? result.medianNs / numBalls : 0.0;
+    result.allocsPerTick = static_cast<double>(allocs) / samples.size();
+    return result;
+}
+
+static void writeJson(FILE* out, const std::vector<BenchResult>& results) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"simulation_step\",\n");
+    fprintf(out, "  \"kernel\": \"%s\",\n", stepKernelName());
+    fprintf(out, "  \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\"balls\": %lu, \"workers\": %u, \"obstacles\": %u, \"collisions\": %u, \"ticks\": %lu, "
+                     "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f, "
+                     "\"ns_per_ball\": %.3f, \"allocs_per_tick\": %.3f}%s\n",
+                static_cast<unsigned long>(r.balls), r.workers, r.obstacles, r.collisions, r.ticks,
+                r.medianNs, r.p99Ns, r.meanNs, r.nsPerBall, r.allocsPerTick,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Parsuje list liczb oddzielonych przecinkami, np. "1,2,4"
+template<typename T>
+static std::vector<T> parseList(const char* text) {
+    std::vector<T> values;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p) break;
+        values.push_back(static_cast<T>(v));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+// Sprawdzenie kernela przed pomiarem: pika odbija si od lewej ciany i w tym samym takcie wraca
+// w GrayObs, wic kernel musi j oznaczy EVENT_SWEEP. Wybrany kernel ma te da bitowo ten sam wynik
+// co wersja skalarna. 16 piek, eby przeszy przez ptl SIMD, a nie tylko przez reszt skalarn.
+static bool checkStepKernel() {
+    const size_t count = 16;
+    const float step = 0.25f;
+    const ObsRect obs = { -0.7f, -0.5f, 0.05f, 1.0f };
+    const float rnd[5] = { 0.5f, 0.5f, 0.0f, 0.0f, 0.0f };
+    BallStore scalar(count), selected(count);
+    for (size_t i = 0; i < count; i++) {
+        // x = -0.85, po odbiciu od ciany -0.99 pika koczy takt w x = -0.65, wewntrz GrayObs
+        float y = -0.45f + 0.06f * i;
+        scalar.spawn(0.01f, -0.85f, y, i, rnd);
+        selected.spawn(0.01f, -0.85f, y, i, rnd);
+        scalar.xSpeed[i] = selected.xSpeed[i] = -1.92f;
+        scalar.ySpeed[i] = selected.ySpeed[i] = 0.0f;
+    }
+    stepKernelScalar(scalar, 0, count, obs, INT_MAX, step);
+    stepKernel(selected, 0, count, obs, INT_MAX, step);
+    for (size_t i = 0; i < count; i++) {
+        if (!(selected.events[i] & EVENT_SWEEP) || selected.events[i] != scalar.events[i] ||
+            memcmp(&selected.x[i], &scalar.x[i], sizeof(float)) != 0) {
+            fprintf(stderr, "Kernel %s: wrong result for ball %lu bouncing into a GrayObs\n",
+                    stepKernelName(), static_cast<unsigned long>(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Benchmark Simulation::step.
+// Opcje: --balls LISTA, --workers LISTA, --obstacles LISTA, --collisions LISTA, --radius R,
+//        --min-ticks N, --max-ticks N, --seconds S (czas pomiaru na konfiguracj),
+//        --bounce-limit N, --out PLIK.json
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    const size_t defaultBalls[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+    opt.ballCounts.assign(defaultBalls, defaultBalls + sizeof(defaultBalls) / sizeof(defaultBalls[0]));
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned w = 1; w < hw; w *= 2) {
+        opt.workerCounts.push_back(w);
+    }
+    opt.workerCounts.push_back(hw);
+    opt.obstacleCounts.push_back(0);
+    opt.obstacleCounts.push_back(1);
+    opt.collisionModes.push_back(0);
+    opt.radius = 0.1f;
+    opt.minTicks = 20;
+    opt.maxTicks = 2000;
+    opt.targetSeconds = 0.5;
+    opt.bounceLimit = INT_MAX;  // Piki nie znikaj, wic liczba piek jest staa w czasie pomiaru
+    opt.outPath = "benchmark.json";
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for option %s\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--balls") == 0) {
+            opt.ballCounts = parseList<size_t>(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            opt.workerCounts = parseList<unsigned>(argv[++i]);
+        } else if (strcmp(argv[i], "--obstacles") == 0) {
+            opt.obstacleCounts = parseList<unsigned>(argv[++i]);
+        } else if (strcmp(argv[i], "--collisions") == 0) {
+            opt.collisionModes = parseList<unsigned>(argv[++i]);
+        } else if (strcmp(argv[i], "--radius") == 0) {
+            opt.radius = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--min-ticks") == 0) {
+            opt.minTicks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--max-ticks") == 0) {
+            opt.maxTicks = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            opt.targetSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bounce-limit") == 0) {
+            opt.bounceLimit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0) {
+            opt.outPath = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    opt.minTicks = std::max(opt.minTicks, 1ul);
+    opt.maxTicks = std::max(opt.maxTicks, opt.minTicks);
+
+    printf("kernel: %s\n", stepKernelName());
+    if (!checkStepKernel()) {
+        return 1;
+    }
+    printf("%10s %8s %10s %10s %8s %12s %12s %10s %10s\n",
+           "balls", "workers", "obstacles", "collisions", "ticks", "median [us]", "p99 [us]", "ns/ball", "allocs");
+
+    std::vector<BenchResult> results;
+    for (size_t b = 0; b < opt.ballCounts.size(); b++) {
+        for (size_t w = 0; w < opt.workerCounts.size(); w++) {
+            for (size_t o = 0; o < opt.obstacleCounts.size(); o++) {
+                for (size_t c = 0; c < opt.collisionModes.size(); c++) {
+                    BenchResult r = runCase(opt, opt.ballCounts[b], opt.workerCounts[w], opt.obstacleCounts[o],
+                                            opt.collisionModes[c]);
+                    printf("%10lu %8u %10u %10u %8lu %12.2f %12.2f %10.3f %10.2f\n",
+                           static_cast<unsigned long>(r.balls), r.workers, r.obstacles, r.collisions, r.ticks,
+                           r.medianNs / 1000.0, r.p99Ns / 1000.0, r.nsPerBall, r.allocsPerTick);
+                    fflush(stdout);
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    FILE* out = fopen(opt.outPath, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", opt.outPath);
+        return 1;
+    }
+    writeJson(out, results);
+    fclose(out);
+    printf("results written to %s\n", opt.outPath);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "checkpoint.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static const char PADDING[CHECKPOINT_ALIGNMENT] = { 0 };
+
+// Liczba bajtw dopenienia do najbliszej wielokrotnoci CHECKPOINT_ALIGNMENT
+static size_t paddingAfter(uint64_t offset) {
+    return static_cast<size_t>((CHECKPOINT_ALIGNMENT - offset % CHECKPOINT_ALIGNMENT) % CHECKPOINT_ALIGNMENT);
+}
+
+CheckpointWriter::CheckpointWriter() : file(nullptr), offset(0), failed(false) {}
+
+// Podmienia plik docelowy gotowym plikiem; rename() w Windows nie nadpisuje istniejcego pliku
+static bool replaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (!file) return;
+    fclose(file);
+    remove(tempPath.c_str());
+}
+
+bool CheckpointWriter::open(const char* path) {
+    targetPath = path;
+    tempPath = targetPath + ".tmp";
+    file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    offset = 0;
+    failed = false;
+    CheckpointHeader header;
+    memcpy(header.magic, "BBCP", 4);
+    header.version = CHECKPOINT_VERSION;
+    header.reserved = 0;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) failed = true;
+    offset += sizeof(header);
+    return !failed;
+}
+
+void CheckpointWriter::writeSection(const char* tag, const void* data, size_t elementSize, size_t count) {
+    if (!file) return;
+    CheckpointSection section;
+    section.tag = checkpointTag(tag);
+    section.elementSize = static_cast<uint32_t>(elementSize);
+    section.count = count;
+    size_t pad = paddingAfter(offset + sizeof(section));
+    size_t bytes = elementSize * count;
+    if (fwrite(&section, sizeof(section), 1, file) != 1) failed = true;
+    if (pad > 0 && fwrite(PADDING, 1, pad, file) != pad) failed = true;
+    if (bytes > 0 && fwrite(data, 1, bytes, file) != bytes) failed = true;
+    offset += sizeof(section) + pad + bytes;
+}
+
+bool CheckpointWriter::close() {
+    if (!file) return !failed;
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+    if (!failed && !replaceFile(tempPath.c_str(), targetPath.c_str())) failed = true;
+    if (failed) remove(tempPath.c_str());
+    return !failed;
+}
+
+CheckpointReader::CheckpointReader() : pos(0) {}
+
+bool CheckpointReader::open(const char* path) {
+    if (!file.open(path)) return false;
+    CheckpointHeader header;
+    if (file.size() < sizeof(header)) return false;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, "BBCP", 4) != 0 || header.version != CHECKPOINT_VERSION) return false;
+    pos = sizeof(header);
+    return true;
+}
+
+const void* CheckpointReader::readSection(const char* tag, size_t elementSize, size_t& count) {
+    CheckpointSection section;
+    if (!file.isOpen() || pos + sizeof(section) > file.size()) return nullptr;
+    memcpy(&section, file.data() + pos, sizeof(section));
+    if (section.tag != checkpointTag(tag) || section.elementSize != elementSize) return nullptr;
+    size_t start = pos + sizeof(section) + paddingAfter(pos + sizeof(section));
+    if (start > file.size() || section.count > (file.size() - start) / elementSize) return nullptr;
+    count = static_cast<size_t>(section.count);
+    pos = start + count * elementSize;
+    return file.data() + start;
+}
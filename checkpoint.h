@@ -0,0 +1,120 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "mapped_file.h"
+
+// Zapis penego stanu symulacji do jednego pliku.
+//
+// Plik to CheckpointHeader i cig sekcji: CheckpointSection, a za nim surowa tablica elementw
+// wyrwnana do 64 bajtw. Tablice s zapisywane tak, jak le w pamici, wic zapis to kilka
+// duych fwrite, a odczyt to zmapowanie pliku i skopiowanie kadej tablicy jednym memcpy.
+// Sekcje s czytane w kolejnoci zapisu; znacznik i rozmiar elementu wykrywaj niezgodny plik.
+
+const uint32_t CHECKPOINT_VERSION = 2;
+const size_t CHECKPOINT_ALIGNMENT = 64;
+
+struct CheckpointHeader {
+    char magic[4];     // "BBCP"
+    uint32_t version;
+    uint64_t reserved;
+};
+
+struct CheckpointSection {
+    uint32_t tag;          // Cztery znaki, np. "BALX"
+    uint32_t elementSize;
+    uint64_t count;
+};
+
+// Znacznik sekcji z czterech znakw
+inline uint32_t checkpointTag(const char* name) {
+    uint32_t tag;
+    memcpy(&tag, name, 4);
+    return tag;
+}
+
+class CheckpointWriter {
+public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    // Zapis idzie do pliku PLIK.tmp, ktry close() podmienia na PLIK dopiero po udanym zapisie,
+    // wic nieudany albo przerwany zapis nie niszczy poprzedniego pliku (np. przy --load i --save tego samego)
+    bool open(const char* path);
+
+    // Zapisuje tablic count elementw jako jedn sekcj
+    template<typename T>
+    void write(const char* tag, const T* data, size_t count) {
+        writeSection(tag, data, sizeof(T), count);
+    }
+
+    template<typename T, typename A>
+    void write(const char* tag, const std::vector<T, A>& data) {
+        writeSection(tag, data.data(), sizeof(T), data.size());
+    }
+
+    // Zapisuje pojedyncz struktur
+    template<typename T>
+    void writeValue(const char* tag, const T& value) {
+        writeSection(tag, &value, sizeof(T), 1);
+    }
+
+    // Zamyka plik i podmienia nim plik docelowy; false (plik docelowy bez zmian), jeli ktry zapis
+    // si nie powid. Obiekt zniszczony bez close() usuwa niepeny plik tymczasowy.
+    bool close();
+
+private:
+    void writeSection(const char* tag, const void* data, size_t elementSize, size_t count);
+
+    FILE* file;
+    std::string targetPath;
+    std::string tempPath;
+    uint64_t offset;
+    bool failed;
+};
+
+class CheckpointReader {
+public:
+    CheckpointReader();
+
+    bool open(const char* path);
+
+    // Wskanik na tablic kolejnej sekcji albo nullptr, jeli sekcja nie pasuje do oczekiwanej
+    template<typename T>
+    const T* read(const char* tag, size_t& count) {
+        return static_cast<const T*>(readSection(tag, sizeof(T), count));
+    }
+
+    // Kopiuje kolejn sekcj do wektora (bez realokacji, jeli ma zarezerwowane miejsce)
+    template<typename T, typename A>
+    bool read(const char* tag, std::vector<T, A>& out) {
+        size_t count;
+        const T* data = read<T>(tag, count);
+        if (!data) return false;
+        out.assign(data, data + count);
+        return true;
+    }
+
+    template<typename T>
+    bool readValue(const char* tag, T& value) {
+        size_t count;
+        const T* data = read<T>(tag, count);
+        if (!data || count != 1) return false;
+        memcpy(&value, data, sizeof(T));
+        return true;
+    }
+
+private:
+    const void* readSection(const char* tag, size_t elementSize, size_t& count);
+
+    MappedFile file;
+    size_t pos;
+};
+
+#endif
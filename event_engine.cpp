@@ -0,0 +1,312 @@
+#include "event_engine.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <limits>
+
+EventEngine::EventEngine()
+    : speed(1.0), wallLo(-1.0), wallHi(1.0), bucketWidth(1.0), currentBucket(0), pending(0), processed(0) {}
+
+void EventEngine::reset(size_t capacity, float ballRadius, const std::vector<ObsRect>& obstacles, double speedScale,
+                        double bucketSeconds, double now) {
+    speed = speedScale;
+    bucketWidth = bucketSeconds;
+    currentBucket = bucketOf(now);
+    wallLo = -1.0 + ballRadius;
+    wallHi = 1.0 - ballRadius;
+
+    // Kolumny GrayObs poszerzone o promie piki i scalone, gdy na siebie nachodz
+    std::vector<std::pair<double, double>> columns;
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        columns.push_back(std::make_pair(static_cast<double>(obstacles[k].x) - ballRadius,
+                                         static_cast<double>(obstacles[k].x) + obstacles[k].width + ballRadius));
+    }
+    std::sort(columns.begin(), columns.end());
+    edges.assign(1, wallLo);
+    nearRegion.clear();
+    for (size_t k = 0; k < columns.size(); k++) {
+        double lo = std::max(columns[k].first, wallLo);
+        double hi = std::min(columns[k].second, wallHi);
+        if (hi <= edges.back()) continue;
+        if (!nearRegion.empty() && nearRegion.back() && lo <= edges.back()) {
+            edges.back() = hi;   // Nachodzi na poprzedni kolumn
+            continue;
+        }
+        if (lo > edges.back()) {
+            edges.push_back(lo);
+            nearRegion.push_back(0);
+        }
+        edges.push_back(hi);
+        nearRegion.push_back(1);
+    }
+    if (edges.back() < wallHi) {
+        edges.push_back(wallHi);
+        nearRegion.push_back(0);
+    }
+
+    // GrayObs kadego obszaru, w kolejnoci lewych krawdzi jak w ObstacleIndex
+    std::vector<uint32_t> byLeft(obstacles.size());
+    for (size_t k = 0; k < byLeft.size(); k++) byLeft[k] = static_cast<uint32_t>(k);
+    std::stable_sort(byLeft.begin(), byLeft.end(), [&obstacles](uint32_t a, uint32_t b) {
+        return obstacles[a].x < obstacles[b].x;
+    });
+    columnStart.assign(1, 0);
+    columnObstacles.clear();
+    for (size_t k = 0; k < nearRegion.size(); k++) {
+        for (size_t n = 0; nearRegion[k] && n < byLeft.size(); n++) {
+            const ObsRect& rect = obstacles[byLeft[n]];
+            if (rect.x - ballRadius < edges[k + 1] && rect.x + rect.width + ballRadius > edges[k]) {
+                columnObstacles.push_back(byLeft[n]);
+            }
+        }
+        columnStart.push_back(static_cast<uint32_t>(columnObstacles.size()));
+    }
+
+    Motion idle;
+    idle.x = idle.y = idle.time = idle.cooldownEnd = 0.0;
+    idle.vx = idle.vy = 0.0f;
+    idle.region = -1;
+    idle.bounces = 0;
+    idle.stamp = 0;
+    idle.nearIndex = UINT32_MAX;
+    motion.assign(capacity, idle);
+    buckets.resize(NUM_BUCKETS);
+    for (size_t b = 0; b < NUM_BUCKETS; b++) {
+        buckets[b].clear();
+    }
+    pending = 0;
+    near.clear();
+    near.reserve(capacity);
+}
+
+// Obszar zawierajcy px; punkt na granicy naley do obszaru po prawej
+int EventEngine::regionOf(double px) const {
+    int k = static_cast<int>(std::upper_bound(edges.begin(), edges.end(), px) - edges.begin()) - 1;
+    int last = static_cast<int>(nearRegion.size()) - 1;
+    return std::min(std::max(k, 0), last);
+}
+
+// Dopisuje pik do listy bliskich albo odwiea jej kopi, jeli ley w kolumnie GrayObs; inaczej usuwa
+void EventEngine::updateNear(BallHandle h) {
+    Motion& m = motion[h.slot];
+    if (!nearRegion[m.region]) {
+        removeNear(h.slot);
+        return;
+    }
+    if (m.nearIndex == UINT32_MAX) {
+        m.nearIndex = static_cast<uint32_t>(near.size());
+        near.push_back(NearBall());
+    }
+    NearBall& b = near[m.nearIndex];
+    b.ball = h;
+    b.vx = m.vx;
+    b.vy = m.vy;
+    b.x = m.x;
+    b.y = m.y;
+    b.time = m.time;
+    b.cooldownEnd = m.cooldownEnd;
+    b.region = m.region;
+}
+
+void EventEngine::removeNear(uint32_t slot) {
+    uint32_t pos = motion[slot].nearIndex;
+    if (pos == UINT32_MAX) return;
+    motion[near.back().ball.slot].nearIndex = pos;
+    near[pos] = near.back();
+    near.pop_back();
+    motion[slot].nearIndex = UINT32_MAX;
+}
+
+void EventEngine::schedule(const BallStore& store, size_t i, double now) {
+    BallHandle h = store.handle(i);
+    Motion& m = motion[h.slot];
+    m.x = store.x[i];
+    m.y = store.y[i];
+    m.time = now;
+    m.cooldownEnd = store.cooldownEnd[i];
+    m.vx = store.xSpeed[i];
+    m.vy = store.ySpeed[i];
+    m.region = regionOf(m.x);
+    m.bounces = store.numBounces[i];
+    m.stamp++;
+    updateNear(h);
+    push(h);
+}
+
+void EventEngine::unschedule(BallStore& store, size_t i, double now) {
+    BallHandle h = store.handle(i);
+    Motion& m = motion[h.slot];
+    if (m.region < 0) return;
+    writeBall(store, i, m, now);
+    m.region = -1;
+    m.stamp++;
+    removeNear(h.slot);
+}
+
+// Stan piki w chwili t zapisany do magazynu
+void EventEngine::writeBall(BallStore& store, size_t i, const Motion& m, double t) const {
+    store.x[i] = static_cast<float>(m.x + m.vx * speed * (t - m.time));
+    store.y[i] = static_cast<float>(m.y + m.vy * speed * (t - m.time));
+    store.xSpeed[i] = m.vx;
+    store.ySpeed[i] = m.vy;
+    store.numBounces[i] = m.bounces;
+}
+
+// Wylicza najblisze zdarzenie piki z jej stanu odniesienia i wstawia je do kolejki
+void EventEngine::push(BallHandle h) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const Motion& m = motion[h.slot];
+    double vx = m.vx * speed;
+    double vy = m.vy * speed;
+
+    // Odcinek [edges[r], edges[r + 1]] koczy si cian albo granic kolumny
+    double dx = inf;
+    int kindX = CROSS_X;
+    if (vx > 0.0) {
+        dx = (edges[m.region + 1] - m.x) / vx;
+        if (m.region + 1 == static_cast<int>(nearRegion.size())) kindX = WALL_X;
+    } else if (vx < 0.0) {
+        dx = (edges[m.region] - m.x) / vx;
+        if (m.region == 0) kindX = WALL_X;
+    }
+    double dy = inf;
+    if (vy > 0.0) {
+        dy = (wallHi - m.y) / vy;
+    } else if (vy < 0.0) {
+        dy = (wallLo - m.y) / vy;
+    }
+    // Pika wysunita za cian odbija si od razu
+    dx = std::max(dx, 0.0);
+    dy = std::max(dy, 0.0);
+    if (dx == inf && dy == inf) return;
+
+    Event e;
+    e.ball = h;
+    e.stamp = m.stamp;
+    if (dx <= dy) {
+        e.time = m.time + dx;
+        e.kind = kindX;
+    } else {
+        e.time = m.time + dy;
+        e.kind = WALL_Y;
+    }
+    long long b = std::max(bucketOf(e.time), currentBucket);
+    buckets[static_cast<size_t>(b) % NUM_BUCKETS].push_back(e);
+    pending++;
+}
+
+size_t EventEngine::advance(BallStore& store, double until, int bounceLimit) {
+    ScopedTraceEvent event("events: advance");
+    size_t retired = 0;
+    long long last = bucketOf(until);
+    for (long long b = currentBucket; b <= last; b++) {
+        // Nowe zdarzenia z tego samego kubeka trafiaj na jego koniec i s obsuone w tej samej ptli;
+        // zdarzenia z dalszych okre koa zostaj na miejscu
+        std::vector<Event>& bucket = buckets[static_cast<size_t>(b) % NUM_BUCKETS];
+        size_t kept = 0;
+        for (size_t j = 0; j < bucket.size(); j++) {
+            Event e = bucket[j];
+            if (e.time > until || bucketOf(e.time) > b) {
+                bucket[kept++] = e;
+                continue;
+            }
+            pending--;
+            if (handle(store, e, bounceLimit)) retired++;
+        }
+        bucket.resize(kept);
+    }
+    currentBucket = last;
+    return retired;
+}
+
+// Obsuguje jedno zdarzenie; zwraca true, jeli pika osigna limit odbi i znikna
+bool EventEngine::handle(BallStore& store, const Event& e, int bounceLimit) {
+    Motion& m = motion[e.ball.slot];
+    // Pika zmienia ruch albo znikna (nowa pika w tym slocie te zmienia stamp)
+    if (m.stamp != e.stamp) return false;
+    processed++;
+
+    // Nowy stan odniesienia w chwili zdarzenia; wsprzdna zdarzenia trafia dokadnie w granic
+    double dt = e.time - m.time;
+    double nx = m.x + m.vx * speed * dt;
+    double ny = m.y + m.vy * speed * dt;
+    bool bounced = false;
+    if (e.kind == WALL_Y) {
+        ny = m.vy > 0.0f ? wallHi : wallLo;
+        m.vy = -m.vy;
+        bounced = true;
+    } else if (m.vx > 0.0f) {
+        nx = edges[m.region + 1];
+        if (e.kind == WALL_X) {
+            m.vx = -m.vx;
+            bounced = true;
+        } else {
+            m.region++;
+        }
+    } else {
+        nx = edges[m.region];
+        if (e.kind == WALL_X) {
+            m.vx = -m.vx;
+            bounced = true;
+        } else {
+            m.region--;
+        }
+    }
+    m.x = nx;
+    m.y = ny;
+    m.time = e.time;
+
+    if (bounced && ++m.bounces >= bounceLimit) {
+        size_t i = store.indexOf(e.ball);
+        writeBall(store, i, m, e.time);
+        store.retire(i);
+        m.region = -1;
+        m.stamp++;
+        removeNear(e.ball.slot);
+        return true;
+    }
+    updateNear(e.ball);
+    push(e.ball);
+    return false;
+}
+
+void EventEngine::writeState(BallStore& store, double now, double prev) const {
+    ScopedTraceEvent event("events: write state");
+    for (size_t i = 0; i < store.size(); i++) {
+        const Motion& m = motion[store.handle(i).slot];
+        if (m.region < 0) continue;   // Przyklejone - pozycj ustawia GrayObs::placeAttached()
+        double t = std::max(prev, m.time);
+        store.prevX[i] = static_cast<float>(m.x + m.vx * speed * (t - m.time));
+        store.prevY[i] = static_cast<float>(m.y + m.vy * speed * (t - m.time));
+        writeBall(store, i, m, now);
+    }
+}
+
+void EventEngine::save(CheckpointWriter& out) const {
+    out.write("EMOT", motion);
+}
+
+bool EventEngine::load(CheckpointReader& in, const BallStore& store) {
+    size_t count;
+    const Motion* saved = in.read<Motion>("EMOT", count);
+    if (!saved || count > motion.size()) return false;
+    std::copy(saved, saved + count, motion.begin());
+
+    // ledzone s dokadnie piki, ktre si poruszaj; wolne sloty nie s ledzone
+    std::vector<uint8_t> moving(motion.size(), 0);
+    for (size_t i = 0; i < store.size(); i++) {
+        if (store.active[i] && store.moving[i]) moving[store.handle(i).slot] = 1;
+    }
+    for (size_t s = 0; s < motion.size(); s++) {
+        Motion& m = motion[s];
+        if ((m.region >= 0) != (moving[s] != 0) || m.region >= static_cast<int32_t>(nearRegion.size())) return false;
+        m.nearIndex = UINT32_MAX;
+    }
+    for (size_t i = 0; i < store.size(); i++) {
+        BallHandle h = store.handle(i);
+        if (motion[h.slot].region < 0) continue;
+        updateNear(h);
+        push(h);
+    }
+    return true;
+}
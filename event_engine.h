@@ -0,0 +1,138 @@
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "ball_store.h"
+
+// Silnik zdarzeniowy: zamiast przesuwa kad pik w kadym takcie liczy analitycznie chwil
+// jej nastpnego zdarzenia i trzyma zdarzenia w kolejce priorytetowej. Midzy zdarzeniami pika
+// porusza si jednostajnie, wic pamitamy tylko punkt i czas ostatniego zdarzenia, a pozycj
+// w dowolnej chwili wyliczamy przy odczycie.
+//
+// Kolejka priorytetowa ma posta kalendarza: kubeki o szerokoci jednego taktu uoone w koo.
+// Piki na siebie nie wpywaj, a kada ma naraz jedno zdarzenie, wic wystarczy, e zdarzenia
+// jednej piki s obsugiwane po kolei - kolejno midzy pikami w kubeku nie ma znaczenia.
+// Wstawienie i zdjcie zdarzenia kosztuj O(1) zamiast O(log n) odwoa do pamici kopca.
+//
+// Zdarzenia piki to odbicie od ciany (osobno w poziomie i w pionie) i przejcie przez granic
+// kolumny, w ktrej poruszaj si GrayObs - GrayObs jed tylko w pionie, wic ich zakres
+// w poziomie jest stay. Tylko piki wewntrz takich kolumn (lista "bliskich") s w kadym takcie
+// sprawdzane z prostoktami GrayObs; koszt taktu jest proporcjonalny do liczby zdarze
+// i bliskich piek, a nie do liczby wszystkich piek.
+//
+// Dane piek s indeksowane slotem uchwytu, wic kompaktowanie magazynu ich nie psuje.
+class EventEngine {
+public:
+    // Bliska pika (wewntrz kolumny GrayObs) - kopia stanu ruchu w cigej tablicy,
+    // eby test z GrayObs w kadym takcie czyta pami po kolei
+    struct NearBall {
+        BallHandle ball;
+        float vx, vy;
+        double x, y, time;   // Punkt i chwila ostatniego zdarzenia
+        double cooldownEnd;
+        int32_t region;      // Obszar w poziomie, patrz regionObstacles()
+    };
+
+    EventEngine();
+
+    // Przygotowuje silnik dla magazynu o danej pojemnoci, promienia piek i prostoktw GrayObs
+    // (liczy si tylko ich zakres w poziomie). speedScale zamienia prdko z magazynu na jednostki
+    // na sekund, bucketSeconds to szeroko kubeka kalendarza, now - bieca chwila.
+    // Usuwa wszystkie zaplanowane zdarzenia.
+    void reset(size_t capacity, float ballRadius, const std::vector<ObsRect>& obstacles, double speedScale,
+               double bucketSeconds, double now);
+
+    // Planuje ruch piki i od chwili now wedug jej pozycji, prdkoci i licznika odbi w magazynie
+    void schedule(const BallStore& store, size_t i, double now);
+
+    // Koczy ledzenie piki i (np. przyklejonej); jej stan w magazynie zostaje ustawiony na chwil now
+    void unschedule(BallStore& store, size_t i, double now);
+
+    // Obsuguje wszystkie zdarzenia do chwili until wcznie. Piki, ktre osigny limit odbi,
+    // s od razu usuwane z magazynu przez BallStore::retire(); zwraca ich liczb
+    size_t advance(BallStore& store, double until, int bounceLimit);
+
+    // Tylko te piki trzeba w kadym takcie sprawdza z GrayObs
+    const std::vector<NearBall>& nearBalls() const { return near; }
+
+    // GrayObs, ktrych kolumna obejmuje obszar region, posortowane wedug lewej krawdzi;
+    // zwraca ich liczb, first wskazuje numery
+    size_t regionObstacles(int32_t region, const uint32_t*& first) const {
+        first = columnObstacles.data() + columnStart[region];
+        return columnStart[region + 1] - columnStart[region];
+    }
+
+    void position(const NearBall& b, double t, float& outX, float& outY) const {
+        outX = static_cast<float>(b.x + b.vx * speed * (t - b.time));
+        outY = static_cast<float>(b.y + b.vy * speed * (t - b.time));
+    }
+
+    // Zapisuje do magazynu stan wszystkich ledzonych piek w chwili now (pozycja, prdko, liczba odbi)
+    // i pozycj w chwili prev (prevX/prevY, do interpolacji przy rysowaniu). Nie zmienia przebiegu symulacji.
+    void writeState(BallStore& store, double now, double prev) const;
+
+    // Zapis i odczyt stanu ruchu wszystkich slotw. load() woa po reset() dla wczytanego magazynu;
+    // planuje od nowa nastpne zdarzenie kadej ledzonej piki, wic wczytany silnik obsuguje
+    // dokadnie te same zdarzenia co zapisany. Zwraca false, gdy stan nie pasuje do magazynu.
+    void save(CheckpointWriter& out) const;
+    bool load(CheckpointReader& in, const BallStore& store);
+
+    size_t pendingEvents() const { return pending; }
+    unsigned long long processedEvents() const { return processed; }
+
+private:
+    enum EventKind {
+        WALL_X,     // Odbicie od lewej lub prawej ciany
+        CROSS_X,    // Przejcie do ssiedniego obszaru w poziomie
+        WALL_Y      // Odbicie od dolnej lub grnej ciany
+    };
+
+    struct Event {
+        double time;
+        BallHandle ball;
+        uint32_t stamp;   // Zdarzenie jest nieaktualne, gdy stamp piki si zmieni
+        int32_t kind;     // EventKind
+    };
+
+    static const size_t NUM_BUCKETS = 256;   // Koo kalendarza; dalsze zdarzenia czekaj kolejne okrenia
+
+    // Stan piki od ostatniego zdarzenia, indeksowany slotem - zdarzenie czyta tylko ten rekord
+    struct Motion {
+        double x, y, time;
+        double cooldownEnd;
+        float vx, vy;          // Prdko w jednostkach magazynu
+        int32_t region;        // Obszar w poziomie albo -1 dla piek nieledzonych
+        int32_t bounces;
+        uint32_t stamp;
+        uint32_t nearIndex;    // Pozycja na licie near albo UINT32_MAX
+    };
+
+    long long bucketOf(double t) const { return static_cast<long long>(std::floor(t / bucketWidth)); }
+    int regionOf(double px) const;
+    void updateNear(BallHandle h);
+    void removeNear(uint32_t slot);
+    void push(BallHandle h);
+    bool handle(BallStore& store, const Event& e, int bounceLimit);
+    void writeBall(BallStore& store, size_t i, const Motion& m, double t) const;
+
+    double speed;                   // Mnonik prdkoci z magazynu na jednostki na sekund
+    double wallLo, wallHi;          // Skrajne pooenia rodka piki
+    std::vector<double> edges;      // Granice obszarw w poziomie, od wallLo do wallHi
+    std::vector<uint8_t> nearRegion;   // 1, jeli obszar [edges[k], edges[k + 1]] ley w kolumnie GrayObs
+    std::vector<uint32_t> columnStart;      // Pocztek listy GrayObs obszaru k w columnObstacles
+    std::vector<uint32_t> columnObstacles;
+
+    std::vector<Motion> motion;
+    double bucketWidth;
+    long long currentBucket;   // Numer pierwszego kubeka, ktry moe zawiera zdarzenia do obsuenia
+    std::vector<std::vector<Event>> buckets;
+    size_t pending;
+    std::vector<NearBall> near;
+    unsigned long long processed;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FRAME_SNAPSHOT_H
+#define FRAME_SNAPSHOT_H
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+#include "ball_store.h"
+
+// Kopia stanu wiata po zakoczonym takcie - wszystko, czego potrzebuje rysowanie.
+// Pozycje z poprzedniego taktu (prevX, prevY, prevObstacles) pozwalaj rysowa stan
+// poredni, gdy ekran odwiea si czciej lub rzadziej ni fizyka.
+struct FrameSnapshot {
+    unsigned long long tick;
+    double simTime;
+    std::vector<float> x, y, radius;
+    std::vector<float> prevX, prevY;
+    std::vector<float> colorR, colorG, colorB;
+    std::vector<ObsRect> obstacles;
+    std::vector<ObsRect> prevObstacles;
+    std::vector<float> obsColorR, obsColorG, obsColorB;
+    size_t attachedCount;
+    unsigned workers;   // Wtki robocze w chwili zrobienia kopii
+    unsigned long long workerBusyNs;   // czny czas pracy wtkw roboczych od pocztku
+
+    // Ustawiane przez wtek publikujcy klatk
+    std::chrono::steady_clock::time_point publishedAt;
+    float tickSeconds;
+
+    FrameSnapshot() : tick(0), simTime(0.0), attachedCount(0), workers(0), workerBusyNs(0), tickSeconds(0.0f) {}
+
+    size_t size() const { return x.size(); }
+
+    // Wspczynnik interpolacji midzy prev a biecym stanem dla chwili now (0..1)
+    float interpolation(std::chrono::steady_clock::time_point now) const {
+        if (tickSeconds <= 0.0f) return 1.0f;
+        float alpha = std::chrono::duration<float>(now - publishedAt).count() / tickSeconds;
+        return alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+    }
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "gray_obs.h"
+#include "metrics.h"
+#include "trace_events.h"
+
+#include <cmath>
+#include <algorithm>
+
+GrayObs::GrayObs(uint32_t id, const CounterRng& rng) : GrayObs(id, rng, -0.55f, 0.75f - 0.8f, 0.4f, 0.8f, 4) {}
+
+GrayObs::GrayObs(uint32_t id, const CounterRng& rng, float x, float y, float width, float height, size_t repelAfter)
+    : obsWidth(width), obsHeight(height), obsX(x), obsY(y),
+      obsSpeed(rng.uniform(STREAM_OBSTACLE, id, 0) * 0.02f + 0.01f), dir(1), repelThreshold(repelAfter),
+      obsId(id), speedDraws(1), prevObsY(y), attachedDirty(false), colorR(0.5f), colorG(0.5f), colorB(0.5f) {}
+
+void GrayObs::update(BallStore& store, const CounterRng& rng, float scale, double simTime, unsigned long long tick,
+                     std::vector<BallHandle>* repelled) {
+    ScopedTraceEvent event("GrayObs::update");
+    prevObsY = obsY;
+    obsY += obsSpeed * dir * scale;
+
+    // Zmiana kierunku ruchu po osigniciu grnej lub dolnej krawdzi
+    if (obsY + obsHeight > 1.0f || obsY < -1.0f) {
+        dir = -dir;
+        obsY += 0.05f * dir;
+        // Przy dugim kroku GrayObs mgby wyjecha dalej ni o ten odskok
+        obsY = std::min(std::max(obsY, -1.0f), 1.0f - obsHeight);
+        obsSpeed = rng.uniform(STREAM_OBSTACLE, obsId, speedDraws++) * 0.02f + 0.005f;
+    }
+
+    // Uchwyty piek, ktre znikny, s usuwane zamiast uywane
+    attachedBalls.erase(std::remove_if(attachedBalls.begin(), attachedBalls.end(),
+                                       [&store](const std::pair<BallHandle, std::pair<float, float>>& a) {
+                                           return store.indexOf(a.first) == SIZE_MAX;
+                                       }),
+                        attachedBalls.end());
+
+    // Przyklejone piki poruszaj si razem z GrayObs - ich pozycja jest wyliczana dopiero przy odczycie
+    if (!attachedBalls.empty()) attachedDirty = true;
+
+    // Odpchnicie piek po przyklejeniu repelThreshold z nich
+    if (attachedBalls.size() >= repelThreshold) {
+        placeAttached(store);
+        float centerX = obsX + obsWidth / 2;
+        float centerY = obsY + obsHeight / 2;
+
+        for (auto& attachedBall : attachedBalls) {
+            size_t i = store.indexOf(attachedBall.first);
+            float jitter = rng.uniform(STREAM_REPEL, store.serial[i], static_cast<uint32_t>(tick));
+            float angle = atan2(store.y[i] - centerY, store.x[i] - centerX) + (jitter - 0.5f) * 0.2f;
+            store.xSpeed[i] = cos(angle) * 0.05f;
+            store.ySpeed[i] = sin(angle) * 0.05f;
+            store.attached[i] = 0;
+            store.wake(i);
+            store.cooldownEnd[i] = simTime + 0.4;
+            if (repelled) repelled->push_back(attachedBall.first);
+        }
+        metrics().count(COUNTER_REPELLED, attachedBalls.size());
+
+        attachedBalls.clear();
+    }
+}
+
+void GrayObs::placeAttached(BallStore& store) {
+    if (!attachedDirty) return;
+    for (auto& attachedBall : attachedBalls) {
+        size_t i = store.indexOf(attachedBall.first);
+        if (i == SIZE_MAX) continue;
+        store.x[i] = obsX + attachedBall.second.first;
+        store.y[i] = obsY + attachedBall.second.second;
+        store.prevX[i] = store.x[i];
+        store.prevY[i] = prevObsY + attachedBall.second.second;
+    }
+    attachedDirty = false;
+}
+
+void GrayObs::attachBall(BallStore& store, size_t i, float attachX, float attachY) {
+    attachedBalls.emplace_back(store.handle(i), std::make_pair(attachX, attachY));
+    store.xSpeed[i] = 0;
+    store.ySpeed[i] = 0;
+    store.attached[i] = 1;
+    store.sleep(i);
+}
+
+// Stan GrayObs w pliku stanu symulacji
+struct GrayObsState {
+    float width, height, x, y, speed;
+    int32_t dir;
+    uint64_t repelThreshold;
+    uint32_t id;
+    uint32_t speedDraws;
+    float colorR, colorG, colorB;
+    uint32_t reserved;   // Jawne dopenienie do 8 bajtw, eby do pliku nie trafiay przypadkowe bajty ze stosu
+};
+
+struct AttachedBallState {
+    BallHandle ball;
+    float offsetX, offsetY;
+};
+
+void GrayObs::save(CheckpointWriter& out) const {
+    GrayObsState state = { obsWidth, obsHeight, obsX, obsY, obsSpeed, dir, repelThreshold, obsId, speedDraws,
+                           colorR, colorG, colorB, 0 };
+    out.writeValue("GOBS", state);
+    std::vector<AttachedBallState> balls(attachedBalls.size());
+    for (size_t k = 0; k < attachedBalls.size(); k++) {
+        AttachedBallState a = { attachedBalls[k].first, attachedBalls[k].second.first, attachedBalls[k].second.second };
+        balls[k] = a;
+    }
+    out.write("GATT", balls);
+}
+
+bool GrayObs::load(CheckpointReader& in) {
+    GrayObsState state;
+    size_t count;
+    if (!in.readValue("GOBS", state)) return false;
+    const AttachedBallState* balls = in.read<AttachedBallState>("GATT", count);
+    if (!balls) return false;
+    obsWidth = state.width;
+    obsHeight = state.height;
+    obsX = state.x;
+    obsY = state.y;
+    obsSpeed = state.speed;
+    dir = state.dir;
+    repelThreshold = static_cast<size_t>(state.repelThreshold);
+    obsId = state.id;
+    speedDraws = state.speedDraws;
+    colorR = state.colorR;
+    colorG = state.colorG;
+    colorB = state.colorB;
+    attachedBalls.clear();
+    for (size_t k = 0; k < count; k++) {
+        attachedBalls.emplace_back(balls[k].ball, std::make_pair(balls[k].offsetX, balls[k].offsetY));
+    }
+    prevObsY = obsY;
+    attachedDirty = !attachedBalls.empty();
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef GRAY_OBS_H
+#define GRAY_OBS_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include "ball_store.h"
+#include "random.h"
+
+// Klasa reprezentujca szary obszar
+class GrayObs {
+private:
+    float obsWidth;
+    float obsHeight;
+    float obsX;
+    float obsY;
+    float obsSpeed;
+    int dir;
+    size_t repelThreshold;   // Liczba przyklejonych piek, po ktrej GrayObs je odpycha
+    uint32_t obsId;          // Identyfikator w generatorze liczb losowych
+    uint32_t speedDraws;     // Ile razy wylosowano ju prdko
+    float prevObsY;          // Pooenie z pocztku ostatniego update(), do interpolacji przyklejonych piek
+    bool attachedDirty;      // Pozycje przyklejonych piek w magazynie s nieaktualne
+
+public:
+    float colorR, colorG, colorB;
+    // Przyklejone piki i ich pooenie w ukadzie GrayObs (wzgldem lewego dolnego rogu)
+    std::vector<std::pair<BallHandle, std::pair<float, float>>> attachedBalls;
+
+    // Klasyczny GrayObs: prostokt 0.4 x 0.8 po lewej stronie, odpycha po czterech pikach
+    GrayObs(uint32_t id, const CounterRng& rng);
+    GrayObs(uint32_t id, const CounterRng& rng, float x, float y, float width, float height, size_t repelAfter);
+
+    ObsRect bounds() const {
+        ObsRect rect = { obsX, obsY, obsWidth, obsHeight };
+        return rect;
+    }
+
+    size_t threshold() const { return repelThreshold; }
+
+    // Przesunicie w pionie w nastpnym wywoaniu update() z tym samym scale
+    // (bez odbicia od krawdzi, ktre update() moe jeszcze doda)
+    float nextShift(float scale) const { return obsSpeed * dir * scale; }
+
+    // Metoda aktualizujca pozycj GrayObs; scale = dugo kroku w taktach, simTime = biecy czas
+    // symulacji w sekundach, tick = numer taktu (do losowania rozrzutu). Przyklejone piki nie s
+    // przesuwane - tylko oznaczane jako nieaktualne (patrz placeAttached()).
+    // Uchwyty odepchnitych piek s dopisywane do repelled, jeli podano
+    void update(BallStore& store, const CounterRng& rng, float scale, double simTime, unsigned long long tick,
+                std::vector<BallHandle>* repelled = nullptr);
+
+    // Zapisuje do magazynu pozycj przyklejonych piek (x/y na teraz, prevX/prevY na pocztek ostatniego
+    // update()), jeli GrayObs poruszy si od ostatniego wywoania. Piki s potrzebne w magazynie tylko
+    // przy rysowaniu, nagrywaniu, zapisie i odpychaniu, wic takt ich nie dotyka.
+    void placeAttached(BallStore& store);
+
+    // Metoda przyklejajca pik do GrayObs; woana tylko z wtku symulacji
+    // (wtki robocze zgaszaj przyklejenia przez kolejk, patrz Simulation::step)
+    void attachBall(BallStore& store, size_t i, float attachX, float attachY);
+
+    // Zapis i odczyt stanu razem z przyklejonymi pikami i ich przesuniciem wzgldem GrayObs
+    void save(CheckpointWriter& out) const;
+    bool load(CheckpointReader& in);
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "headless.h"
+#include "simulation.h"
+#include "random.h"
+#include "trace.h"
+#include "metrics.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <vector>
+
+// Skrt FNV-1a stanu piek - dwa przebiegi z tym samym ziarnem musz da ten sam wynik
+static unsigned stateHash(const BallStore& store) {
+    unsigned hash = 2166136261u;
+    const FloatArray* arrays[] = { &store.x, &store.y, &store.xSpeed, &store.ySpeed };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(arrays[a]->data());
+        for (size_t i = 0; i < arrays[a]->size() * sizeof(float); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Dekoduje wszystkie klatki nagrania i wypisuje jego rozmiar i szybko odczytu
+static int replayTrace(const char* path) {
+    TraceReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "Cannot read trace %s\n", path);
+        return 1;
+    }
+    FrameSnapshot frame;
+    unsigned long long ballFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < reader.numFrames(); f++) {
+        if (!reader.read(f, frame)) {
+            fprintf(stderr, "Corrupt frame %lu in %s\n", static_cast<unsigned long>(f), path);
+            return 1;
+        }
+        ballFrames += frame.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t numFrames = reader.numFrames();
+    printf("frames:         %lu (ticks %llu..%llu, %.1f s simulated)\n", static_cast<unsigned long>(numFrames),
+           static_cast<unsigned long long>(reader.tickOf(0)), static_cast<unsigned long long>(reader.tickOf(numFrames - 1)),
+           frame.simTime);
+    printf("seed:           %llu\n", static_cast<unsigned long long>(reader.header().seed));
+    printf("file size:      %lu bytes (%.2f bytes/ball/frame)\n", static_cast<unsigned long>(reader.fileSize()),
+           ballFrames > 0 ? static_cast<double>(reader.fileSize()) / ballFrames : 0.0);
+    printf("balls left:     %lu\n", static_cast<unsigned long>(frame.size()));
+    printf("attached:       %lu\n", static_cast<unsigned long>(frame.attachedCount));
+    printf("decode time:    %.3f s\n", seconds);
+    printf("frames/s:       %.1f\n", seconds > 0 ? numFrames / seconds : 0.0);
+    return 0;
+}
+
+int runHeadless(int argc, char **argv) {
+    SimulationConfig config;
+    unsigned long long numTicks = 10000;
+    size_t initialBalls = 1000;
+    double spawnRate = 0.0;
+    float dt = BASE_TICK;
+    bool scatter = false;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* loadPath = nullptr;
+    const char* savePath = nullptr;
+    const char* metricsPath = nullptr;
+    const char* profilePath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) continue;
+        if (strcmp(argv[i], "--no-ball-collisions") == 0) {
+            config.ballCollisions = false;
+            continue;
+        }
+        if (strcmp(argv[i], "--fixed-workers") == 0) {
+            config.adaptiveWorkers = false;
+            continue;
+        }
+        if (strcmp(argv[i], "--scatter") == 0) {
+            scatter = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--events") == 0) {
+            config.eventDriven = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for option %s\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--ticks") == 0) {
+            numTicks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--balls") == 0) {
+            initialBalls = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--spawn-rate") == 0) {
+            spawnRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bounce-limit") == 0) {
+            config.bounceLimit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            config.numWorkers = static_cast<unsigned>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--dt") == 0) {
+            dt = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--hz") == 0) {
+            dt = static_cast<float>(1.0 / atof(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            config.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--obstacles") == 0) {
+            config.numObstacles = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--radius") == 0) {
+            config.ballRadius = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--record") == 0) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--load") == 0) {
+            loadPath = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0) {
+            savePath = argv[++i];
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            metricsPath = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profilePath = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (replayPath) return replayTrace(replayPath);
+    setTraceThreadName("simulation");
+    if (profilePath) enableTraceEvents();
+
+    // Magazyn piek ma sta pojemno - musi pomieci wszystkie piki, ktre mog si pojawi
+    size_t expectedSpawns = static_cast<size_t>(spawnRate * dt * numTicks) + 1;
+    config.ballCapacity = std::max(config.ballCapacity, initialBalls + expectedSpawns);
+    Simulation sim(config);
+    if (loadPath) {
+        // Start od zapisanego stanu zamiast od nowych piek
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!sim.loadCheckpoint(loadPath)) {
+            fprintf(stderr, "Cannot load checkpoint %s\n", loadPath);
+            return 1;
+        }
+        printf("loaded:         %s (%lu balls, tick %llu) in %.3f s\n", loadPath,
+               static_cast<unsigned long>(sim.balls().size()), sim.tickCount(),
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count());
+    } else if (scatter) {
+        // Losowe punkty wewntrz cian, wylosowane jednym wywoaniem
+        std::vector<float> rnd(2 * initialBalls);
+        sim.random().fill(STREAM_SCATTER, 0, rnd.data(), rnd.size());
+        float span = 1.0f - config.ballRadius;
+        for (size_t i = 0; i < initialBalls; i++) {
+            sim.spawnBallAt((rnd[2 * i] * 2.0f - 1.0f) * span, (rnd[2 * i + 1] * 2.0f - 1.0f) * span);
+        }
+    } else {
+        for (size_t i = 0; i < initialBalls; i++) {
+            sim.spawnBall();
+        }
+    }
+
+    TraceWriter trace;
+    if (recordPath && !trace.open(recordPath, dt, sim.random().seed())) {
+        fprintf(stderr, "Cannot write trace %s\n", recordPath);
+        return 1;
+    }
+
+    double spawnAccum = 0.0;
+    unsigned long long ballSteps = 0;
+    unsigned long long totalContacts = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long t = 0; t < numTicks; t++) {
+        spawnAccum += spawnRate * dt;
+        while (spawnAccum >= 1.0) {
+            sim.spawnBall();
+            spawnAccum -= 1.0;
+        }
+        ballSteps += sim.balls().size();
+        sim.step(dt);
+        totalContacts += sim.contactCount();
+        if (recordPath) {
+            sim.syncPositions();
+            trace.record(sim);
+        }
+        if (metricsPath) {
+            MetricGauges gauges = { sim.tickCount(), sim.balls().size(), sim.attachedCount(), sim.numWorkers() };
+            metrics().sample(gauges);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sim.syncPositions();
+    if (recordPath && !trace.close()) {
+        fprintf(stderr, "Error while writing trace %s\n", recordPath);
+        return 1;
+    }
+
+    ThreadStats threads = sim.threadStats();
+    printf("workers:        %u (cap %u, started %llu, retired %llu)\n",
+           threads.live, threads.cap, threads.started, threads.retired);
+    printf("ticks:          %llu (%.1f s simulated)\n", numTicks, numTicks * dt);
+    printf("balls left:     %lu\n", static_cast<unsigned long>(sim.balls().size()));
+    printf("attached:       %lu\n", static_cast<unsigned long>(sim.attachedCount()));
+    printf("collisions:     %llu%s\n", totalContacts, sim.config().ballCollisions ? "" : " (disabled)");
+    if (config.eventDriven) {
+        printf("events:         %llu (%.0f/s)\n", sim.eventCount(), seconds > 0 ? sim.eventCount() / seconds : 0.0);
+    }
+    printf("wall time:      %.3f s\n", seconds);
+    printf("ticks/s:        %.1f\n", seconds > 0 ? numTicks / seconds : 0.0);
+    printf("ball steps/s:   %.0f\n", seconds > 0 ? ballSteps / seconds : 0.0);
+    printf("ns/ball step:   %.2f\n", ballSteps > 0 ? seconds * 1e9 / ballSteps : 0.0);
+    if (savePath) {
+        auto saveStart = std::chrono::steady_clock::now();
+        if (!sim.saveCheckpoint(savePath)) {
+            fprintf(stderr, "Cannot save checkpoint %s\n", savePath);
+            return 1;
+        }
+        printf("saved:          %s in %.3f s\n", savePath,
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - saveStart).count());
+    }
+    if (recordPath) {
+        printf("trace:          %s (%llu frames, %llu bytes)\n", recordPath,
+               static_cast<unsigned long long>(trace.framesWritten()), static_cast<unsigned long long>(trace.bytesWritten()));
+    }
+    if (metricsPath) {
+        std::string base(metricsPath);
+        if (!metrics().writeCsv((base + ".csv").c_str()) || !metrics().writeJson((base + ".json").c_str())) {
+            fprintf(stderr, "Cannot write metrics to %s\n", metricsPath);
+            return 1;
+        }
+        LatencyHistogram steps;
+        metrics().histogram(HIST_STEP, steps);
+        printf("step p50/p99:   %.1f / %.1f us (metrics in %s.csv, %s.json)\n", steps.percentile(0.5) / 1000.0,
+               steps.percentile(0.99) / 1000.0, metricsPath, metricsPath);
+    }
+    if (profilePath) {
+        if (!writeChromeTrace(profilePath)) {
+            fprintf(stderr, "Cannot write timeline %s\n", profilePath);
+            return 1;
+        }
+        printf("timeline:       %s\n", profilePath);
+    }
+    printf("state hash:     %08x\n", stateHash(sim.balls()));
+    return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Uruchamia symulacj bez okna i wypisuje przepustowo.
+// Opcje: --ticks N, --balls N, --spawn-rate R (piek na sekund symulacji),
+//        --bounce-limit N, --workers N, --fixed-workers, --dt S albo --hz N (dugo kroku), --seed N,
+//        --radius R, --scatter, --obstacles N, --no-ball-collisions, --events (silnik zdarzeniowy),
+//        --record PLIK (nagrywa kady takt), --replay PLIK (dekoduje nagranie zamiast symulacji),
+//        --load PLIK (start od zapisanego stanu), --save PLIK (zapis stanu po ostatnim takcie),
+//        --metrics PRZEDROSTEK (prbka metryk co takt, zapis do PRZEDROSTEK.csv i .json),
+//        --profile PLIK (o czasu wtkw w formacie Chrome trace)
+int runHeadless(int argc, char **argv);
+
+#endif
@@ -0,0 +1,6 @@
+#include "headless.h"
+
+// Funkcja gwna wersji bez okna
+int main(int argc, char **argv) {
+    return runHeadless(argc, argv);
+}
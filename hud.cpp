@@ -0,0 +1,103 @@
+#include "hud.h"
+
+#include <GL/freeglut.h>
+#include <cstdio>
+
+static const double WINDOW_SECONDS = 0.5;
+static const float GRAPH_MAX_MS = 50.0f;   // Grna krawd wykresu
+static const int PANEL_WIDTH = 260;
+static const int LINE_HEIGHT = 15;
+static const int GRAPH_HEIGHT = 60;
+
+PerformanceHud::PerformanceHud()
+    : visible(false), historyPos(0), windowFrames(0), windowTick(0), windowBusyNs(0), windowSimTime(0.0),
+      fps(0.0f), physicsHz(0.0f), simRate(0.0f), utilization(0.0f), simTime(0.0), balls(0), attached(0), workers(0) {
+    for (int i = 0; i < HISTORY; i++) frameMs[i] = 0.0f;
+}
+
+void PerformanceHud::frame(const FrameSnapshot& snapshot, std::chrono::steady_clock::time_point now) {
+    if (lastFrame.time_since_epoch().count() != 0) {
+        frameMs[historyPos] = std::chrono::duration<float, std::milli>(now - lastFrame).count();
+        historyPos = (historyPos + 1) % HISTORY;
+    } else {
+        windowStart = now;
+        windowTick = snapshot.tick;
+        windowBusyNs = snapshot.workerBusyNs;
+        windowSimTime = snapshot.simTime;
+    }
+    lastFrame = now;
+    windowFrames++;
+    balls = snapshot.size();
+    attached = snapshot.attachedCount;
+    workers = snapshot.workers;
+    simTime = snapshot.simTime;
+
+    double elapsed = std::chrono::duration<double>(now - windowStart).count();
+    if (elapsed >= WINDOW_SECONDS) {
+        fps = static_cast<float>(windowFrames / elapsed);
+        physicsHz = snapshot.tick >= windowTick ? static_cast<float>((snapshot.tick - windowTick) / elapsed) : 0.0f;
+        double busy = snapshot.workerBusyNs >= windowBusyNs ? (snapshot.workerBusyNs - windowBusyNs) * 1e-9 : 0.0;
+        simRate = snapshot.simTime >= windowSimTime ? static_cast<float>((snapshot.simTime - windowSimTime) / elapsed) : 0.0f;
+        utilization = workers > 0 ? static_cast<float>(busy / (elapsed * workers)) : 0.0f;
+        windowStart = now;
+        windowFrames = 0;
+        windowTick = snapshot.tick;
+        windowBusyNs = snapshot.workerBusyNs;
+        windowSimTime = snapshot.simTime;
+    }
+}
+
+void PerformanceHud::draw() const {
+    if (!visible) return;
+    float width = static_cast<float>(glutGet(GLUT_WINDOW_WIDTH));
+    float height = static_cast<float>(glutGet(GLUT_WINDOW_HEIGHT));
+    if (width <= 0.0f || height <= 0.0f) return;
+    // Wsprzdne w pikselach od lewego grnego rogu
+    float sx = 2.0f / width, sy = 2.0f / height;
+    const int numLines = 6;
+    int panelHeight = 8 + numLines * LINE_HEIGHT + 8 + GRAPH_HEIGHT + 8;
+
+    glLoadIdentity();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+    glBegin(GL_QUADS);
+    glVertex2f(-1.0f, 1.0f);
+    glVertex2f(-1.0f + PANEL_WIDTH * sx, 1.0f);
+    glVertex2f(-1.0f + PANEL_WIDTH * sx, 1.0f - panelHeight * sy);
+    glVertex2f(-1.0f, 1.0f - panelHeight * sy);
+    glEnd();
+    glDisable(GL_BLEND);
+
+    char lines[numLines][64];
+    snprintf(lines[0], sizeof(lines[0]), "FPS:       %.1f", fps);
+    snprintf(lines[1], sizeof(lines[1]), "Physics:   %.1f Hz", physicsHz);
+    snprintf(lines[2], sizeof(lines[2]), "Sim time:  %.0f s (x%.1f)", simTime, simRate);
+    snprintf(lines[3], sizeof(lines[3]), "Balls:     %lu", static_cast<unsigned long>(balls));
+    snprintf(lines[4], sizeof(lines[4]), "Attached:  %lu", static_cast<unsigned long>(attached));
+    snprintf(lines[5], sizeof(lines[5]), "Workers:   %u (%.0f%% busy)", workers, utilization * 100.0f);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    for (int i = 0; i < numLines; i++) {
+        glRasterPos2f(-1.0f + 8 * sx, 1.0f - (8 + (i + 1) * LINE_HEIGHT - 3) * sy);
+        glutBitmapString(GLUT_BITMAP_8_BY_13, reinterpret_cast<const unsigned char*>(lines[i]));
+    }
+
+    // Wykres czasw klatek, najstarsza z lewej; linia odniesienia na 60 FPS
+    float graphLeft = -1.0f + 8 * sx;
+    float graphBottom = 1.0f - (panelHeight - 8) * sy;
+    float graphScale = GRAPH_HEIGHT * sy / GRAPH_MAX_MS;
+    float step = (PANEL_WIDTH - 16) * sx / (HISTORY - 1);
+    glColor3f(0.4f, 0.4f, 0.4f);
+    glBegin(GL_LINES);
+    glVertex2f(graphLeft, graphBottom + 1000.0f / 60.0f * graphScale);
+    glVertex2f(graphLeft + (HISTORY - 1) * step, graphBottom + 1000.0f / 60.0f * graphScale);
+    glEnd();
+    glColor3f(0.3f, 1.0f, 0.3f);
+    glBegin(GL_LINE_STRIP);
+    for (int i = 0; i < HISTORY; i++) {
+        float ms = frameMs[(historyPos + i) % HISTORY];
+        if (ms > GRAPH_MAX_MS) ms = GRAPH_MAX_MS;
+        glVertex2f(graphLeft + i * step, graphBottom + ms * graphScale);
+    }
+    glEnd();
+}
@@ -0,0 +1,50 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <chrono>
+#include <cstddef>
+
+#include "frame_snapshot.h"
+
+// Nakadka z danymi o wydajnoci rysowana na wierzchu sceny: FPS, czstotliwo fizyki,
+// zegar symulacji i jego tempo wzgldem czasu rzeczywistego, liczba piek i przyklejonych piek, obcienie wtkw roboczych i wykres czasw ostatnich klatek.
+// Dane pochodz z kopii stanu (FrameSnapshot) i licznikw puli, wic HUD niczego nie blokuje.
+class PerformanceHud {
+public:
+    PerformanceHud();
+
+    void toggle() { visible = !visible; }
+    bool isVisible() const { return visible; }
+
+    // Wywoywane w kadej klatce, take gdy HUD jest ukryty, eby wykres by od razu peny
+    void frame(const FrameSnapshot& snapshot, std::chrono::steady_clock::time_point now);
+
+    // Rysuje nakadk w lewym grnym rogu okna
+    void draw() const;
+
+private:
+    static const int HISTORY = 240;   // Liczba klatek na wykresie
+
+    bool visible;
+    float frameMs[HISTORY];
+    int historyPos;
+    std::chrono::steady_clock::time_point lastFrame;
+
+    // Wartoci uredniane w oknie p sekundy
+    std::chrono::steady_clock::time_point windowStart;
+    unsigned windowFrames;
+    unsigned long long windowTick;
+    unsigned long long windowBusyNs;
+    double windowSimTime;
+    float fps;
+    float physicsHz;
+    float simRate;      // Sekundy symulacji na sekund czasu rzeczywistego
+    float utilization;
+
+    double simTime;
+    size_t balls;
+    size_t attached;
+    unsigned workers;
+};
+
+#endif
@@ -1,207 +1,278 @@
 #include <GL/freeglut.h>
 #include <vector>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <ctime>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <chrono>
-#include <random>
 #include <memory>
-#include <algorithm>
-#include <cmath>
 #include <condition_variable>
+#include <string>
 
-int BOUNCE_LIMIT = 5;
-
-class GrayObs;
-class Ball;
+#include "simulation.h"
+#include "headless.h"
+#include "triple_buffer.h"
+#include "renderer.h"
+#include "hud.h"
+#include "trace.h"
+#include "metrics.h"
+#include "trace_events.h"
 
 std::mutex mutex;
 std::condition_variable ballCond;
 std::atomic<bool> running(true);
-std::vector<std::thread> ballThreads;
-std::vector<std::unique_ptr<Ball>> balls;
-std::chrono::steady_clock::time_point lastBallTime = std::chrono::steady_clock::now();
 int refreshMillis = 16;
-std::random_device rd;
-std::mt19937 gen(rd());
-std::uniform_real_distribution<> dis(0.0, 1.0);
-
-float getRandom() {
-    return dis(gen);
+std::unique_ptr<Simulation> sim;
+std::thread physicsThread;
+TripleBuffer<FrameSnapshot> frames;  // Klatki przekazywane z wtku fizyki do display() bez blokad
+BallRenderer ballRenderer;
+PerformanceHud hud;                  // Nakadka z wydajnoci, klawisz h
+float physicsDt = BASE_TICK;         // Stay krok fizyki w sekundach (--hz)
+const int MAX_CATCH_UP_STEPS = 8;    // Tyle krokw najwyej nadrabiamy po przestoju (razy tempo, gdy wiksze od 1)
+std::atomic<double> timeScale(1.0);  // Sekundy symulacji na sekund czasu rzeczywistego (--time-scale, klawisze - +)
+bool paceChanged = false;            // Zmiana tempa budzi wtek fizyki; chronione przez mutex
+std::atomic<bool> fastForward(false);   // Fizyka bez czekania, rysowana co FAST_FRAME_MILLIS (--fast, klawisz f)
+const double MIN_TIME_SCALE = 1.0 / 64.0;
+const double MAX_TIME_SCALE = 64.0;
+const int FAST_FRAME_MILLIS = 100;   // Odstp publikowanych klatek w trybie najszybszym
+const int FAST_LOCK_MILLIS = 2;      // Tak dugo najwyej trzymamy mutex w trybie najszybszym (plus jeden krok)
+TraceWriter traceWriter;             // Nagrywanie (--record)
+bool recording = false;
+TraceReader traceReader;             // Odtwarzanie (--replay) zamiast symulacji
+bool replaying = false;
+double replaySpeed = 1.0;            // Klatki nagrania na takt czasu rzeczywistego; chronione przez mutex
+bool replayPaused = false;
+double replayPosition = 0.0;         // Bieca klatka nagrania (z czci uamkow)
+const char* savePath = nullptr;      // Plik stanu zapisywany przy wyjciu (--save)
+const char* metricsPath = nullptr;   // Przedrostek plikw z metrykami zapisywanych przy wyjciu (--metrics)
+const char* profilePath = nullptr;   // Plik osi czasu w formacie Chrome trace zapisywany przy wyjciu (--profile)
+std::chrono::steady_clock::time_point lastDisplay;
+
+// Bierze globalny mutex i zapisuje czas czekania na niego (0, gdy by wolny).
+// Ponowne wzicie mutexu po obudzeniu z wait_until nie jest mierzone.
+std::unique_lock<std::mutex> lockMutex() {
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        metrics().record(HIST_LOCK_WAIT, 0);
+    } else {
+        ScopedLatency wait(HIST_LOCK_WAIT);
+        lock.lock();
+    }
+    return lock;
 }
 
-// Klasa reprezentujca pik
-class Ball {
-public:
-    GLfloat radius;
-    GLfloat x, y;
-    GLfloat xSpeed, ySpeed;
-    GLfloat colorR, colorG, colorB;
-    int numBounces;
-    bool active;
-    bool attached;
-    std::chrono::steady_clock::time_point cooldownEnd;
-
-    Ball() : radius(0.1f), x(0.0f), y(-1.0f + radius),
-             xSpeed(getRandom() * 0.24f - 0.12f),
-             ySpeed(getRandom() * 0.16f - 0.08f),
-             colorR(getRandom()), colorG(getRandom()), colorB(getRandom()),
-             numBounces(0), active(true), attached(false) {}
-
-    void run();  // Metoda uruchamiajca wtek piki
-    void draw();  // Metoda rysujca pik
-};
-
-// Klasa reprezentujca szary obszar
-class GrayObs {
-private:
-    GLfloat obsWidth;
-    GLfloat obsHeight;
-    GLfloat obsX;
-    GLfloat obsY;
-    GLfloat obsSpeed;
-    GLfloat colorR, colorG, colorB;
-    int dir;
-
-public:
-    std::vector<std::pair<Ball*, std::pair<GLfloat, GLfloat>>> attachedBalls;
-
-    GrayObs() : obsWidth(0.4f), obsHeight(0.8f), obsX(-0.55f), obsY(0.75f - obsHeight),
-                obsSpeed(getRandom() * 0.02f + 0.01f),
-                colorR(0.5f), colorG(0.5f), colorB(0.5f), dir(1) {}
-    // Metoda rysujca GrayObs
-    void draw() {
-        glColor3f(colorR, colorG, colorB);
-        glTranslatef(obsX, obsY, 0.0f);
-        glBegin(GL_QUADS);
-        glVertex2f(0.0f, 0.0f);
-        glVertex2f(obsWidth, 0.0f);
-        glVertex2f(obsWidth, obsHeight);
-        glVertex2f(0.0f, obsHeight);
-        glEnd();
+// Zapisuje metryki do PREFIX.csv (prbka na klatk) i PREFIX.json (podsumowanie)
+void exportMetrics(const char* prefix) {
+    std::string base(prefix);
+    bool ok = metrics().writeCsv((base + ".csv").c_str()) && metrics().writeJson((base + ".json").c_str());
+    if (ok) {
+        printf("Metrics written to %s.csv and %s.json\n", prefix, prefix);
+    } else {
+        fprintf(stderr, "Cannot write metrics to %s\n", prefix);
     }
+}
 
-    // Metoda aktualizujca pozycj GrayObs i przyklejonych piek
-    void update() {
-        obsY += obsSpeed * dir;
+// Jeden krok fizyki razem z nowymi pikami i nagrywaniem; woa z wzitym mutexem.
+// Nowe piki co 2-10 s czasu symulacji, wic przy zmienionym tempie i w trybie najszybszym
+// na sekund symulacji przypada tyle samo piek co w zwykym biegu.
+void stepPhysics() {
+    sim->spawnScheduled();
+    sim->step(physicsDt);
+    if (recording) {
+        sim->syncPositions();
+        traceWriter.record(*sim);
+    }
+}
 
-        // Zmiana kierunku ruchu po osigniciu grnej lub dolnej krawdzi
-        if (obsY + obsHeight > 1.0f || obsY < -1.0f) {
-            dir = -dir;
-            obsY += 0.05f * dir;
-            obsSpeed = getRandom() * 0.02f + 0.005f;
-        }
+// Kopiuje stan po ostatnim kroku do wolnej klatki; tickSeconds 0 wycza interpolacj.
+// Woa z wzitym mutexem, frames.publish() ju po jego zwolnieniu.
+void prepareFrame(std::chrono::steady_clock::time_point now, float tickSeconds) {
+    ScopedTraceEvent snapshotEvent("snapshot");
+    FrameSnapshot& frame = frames.writeBuffer();
+    sim->syncPositions();
+    sim->snapshot(frame);
+    frame.publishedAt = now;
+    frame.tickSeconds = tickSeconds;
+}
 
-        // Aktualizacja pozycji przyklejonych piek
-        for (auto& attachedBall : attachedBalls) {
-            Ball* ball = attachedBall.first;
-            ball->x = obsX + attachedBall.second.first;
-            ball->y = obsY + attachedBall.second.second;
+// Funkcja wtku fizyki - stay krok z akumulatorem, niezaleny od czstotliwoci odwieania ekranu.
+// Czas rzeczywisty jest mnoony przez tempo (timeScale). W trybie najszybszym kroki id bez czekania,
+// a klatka jest publikowana tylko co FAST_FRAME_MILLIS. Po kadej porcji krokw publikuje gotow klatk.
+void simulateBalls() {
+    setTraceThreadName("physics");
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration stepDuration =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(physicsDt));
+    Clock::time_point previous = Clock::now();
+    Clock::time_point nextTick = previous + stepDuration;
+    Clock::duration accumulator(0);
+    while (running) {
+        std::unique_lock<std::mutex> lock = lockMutex();
+        if (!fastForward) {
+            ballCond.wait_until(lock, nextTick, [] { return !running || paceChanged; });
+            if (!running) break; // Wyjcie, jeli running jest false
         }
-
-        // Odpchnicie piek po przyklejeniu czterech z nich
-        if (attachedBalls.size() >= 4) {
-            GLfloat centerX = obsX + obsWidth / 2;
-            GLfloat centerY = obsY + obsHeight / 2;
-
-            for (auto& attachedBall : attachedBalls) {
-                Ball* ball = attachedBall.first;
-                GLfloat angle = atan2(ball->y - centerY, ball->x - centerX) + (getRandom() - 0.5f) * 0.2f;
-                ball->xSpeed = cos(angle) * 0.05f;
-                ball->ySpeed = sin(angle) * 0.05f;
-                ball->attached = false;
-                ball->cooldownEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(400);
+        paceChanged = false;
+        Clock::time_point now = Clock::now();
+        double scale = timeScale.load(std::memory_order_relaxed);
+
+        ScopedTraceEvent tickEvent("physics tick");
+        bool stepped = false;
+        if (fastForward) {
+            // Mutex jest zwalniany co FAST_LOCK_MILLIS, wic klawiatura nie czeka na ca porcj krokw
+            Clock::time_point frameEnd = now + std::chrono::milliseconds(FAST_FRAME_MILLIS);
+            Clock::time_point unlockAt = now + std::chrono::milliseconds(FAST_LOCK_MILLIS);
+            for (;;) {
+                stepPhysics();
+                Clock::time_point t = Clock::now();
+                if (!running || !fastForward || t >= frameEnd) break;
+                if (t >= unlockAt) {
+                    lock.unlock();
+                    std::this_thread::yield();
+                    lock.lock();
+                    unlockAt = t + std::chrono::milliseconds(FAST_LOCK_MILLIS);
+                }
             }
-
-            attachedBalls.clear();
+            now = Clock::now();
+            accumulator = Clock::duration(0);
+            prepareFrame(now, 0.0f);
+            stepped = true;
+        } else {
+            accumulator += std::chrono::duration_cast<Clock::duration>((now - previous) * scale);
+            double maxSteps = MAX_CATCH_UP_STEPS * std::max(scale, 1.0);
+            if (accumulator > stepDuration * maxSteps) {
+                accumulator = std::chrono::duration_cast<Clock::duration>(stepDuration * maxSteps);
+            }
+            while (accumulator >= stepDuration) {
+                stepPhysics();
+                accumulator -= stepDuration;
+                stepped = true;
+            }
+            if (stepped) prepareFrame(now, static_cast<float>(physicsDt / scale));
         }
-    }
-
-    // Metoda przyklejajca pik do GrayObs
-    void attachBall(Ball* ball, GLfloat attachX, GLfloat attachY) {
-        attachedBalls.emplace_back(ball, std::make_pair(attachX, attachY));
-        ball->xSpeed = 0;
-        ball->ySpeed = 0;
-        ball->attached = true;
-    }
-
-    // Metoda sprawdzajca kolizj piki z GrayObs
-    bool checkCollision(Ball* ball, GLfloat& attachX, GLfloat& attachY) {
-        if (ball->x + ball->radius > obsX && ball->x - ball->radius < obsX + obsWidth &&
-            ball->y + ball->radius > obsY && ball->y - ball->radius < obsY + obsHeight) {
+        previous = now;
+        // Czas rzeczywisty do nastpnego kroku
+        nextTick = now + std::chrono::duration_cast<Clock::duration>((stepDuration - accumulator) / scale);
+        lock.unlock();
 
-            attachX = ball->x - obsX;
-            attachY = ball->y - obsY;
-            return true;
+        if (stepped) {
+            frames.publish();
         }
-        return false;
+        if (fastForward) std::this_thread::yield();   // Klawiatura moe wzi mutex midzy porcjami
     }
-};
-
-GrayObs grayObs;  // Globalna instancja GrayObs
+}
 
-// Metoda uruchamiajca wtek piki
-void Ball::run() {
-    while (running && active) {
-        std::unique_lock<std::mutex> lock(mutex);
-        if (ballCond.wait_for(lock, std::chrono::milliseconds(16), [this] { return !active || !running; })) {
-            if (!running || !active) break; // Wyjcie, jeli pika nie jest aktywna lub running jest false
+// Funkcja wtku odtwarzania - przesuwa pozycj w nagraniu zgodnie z prdkoci i publikuje klatki
+// tak samo jak wtek fizyki, wic rysowanie nie wie, skd pochodz
+void replayFrames() {
+    setTraceThreadName("replay");
+    typedef std::chrono::steady_clock Clock;
+    float tickSeconds = traceReader.header().tickSeconds;
+    double lastFrame = static_cast<double>(traceReader.numFrames() - 1);
+    Clock::time_point previous = Clock::now();
+    size_t shown = SIZE_MAX;
+    while (running) {
+        std::unique_lock<std::mutex> lock = lockMutex();
+        if (ballCond.wait_for(lock, std::chrono::milliseconds(refreshMillis / 2), [] { return !running; })) {
+            break; // Wyjcie, jeli running jest false
         }
-        if (numBounces < BOUNCE_LIMIT && !attached) {
-            x += xSpeed / 4;
-            y += ySpeed / 4;
-            if (x + radius > 1.0f || x - radius < -1.0f) {
-                xSpeed = -xSpeed;
-                numBounces++;
-            }
-            if (y + radius > 1.0f || y - radius < -1.0f) {
-                ySpeed = -ySpeed;
-                numBounces++;
-            }
-            GLfloat attachX, attachY;
-            if (grayObs.checkCollision(this, attachX, attachY) && std::chrono::steady_clock::now() > cooldownEnd) {
-                grayObs.attachBall(this, attachX, attachY);
-            }
-        } else if (!attached) {
-            active = false;
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - previous).count();
+        previous = now;
+        if (!replayPaused) {
+            replayPosition += elapsed / tickSeconds * replaySpeed;
+        }
+        replayPosition = std::min(std::max(replayPosition, 0.0), lastFrame);
+        size_t target = static_cast<size_t>(replayPosition);
+        float speed = static_cast<float>(std::fabs(replaySpeed));
+        lock.unlock();
+
+        if (target == shown) continue;
+        ScopedTraceEvent decodeEvent("decode frame");
+        FrameSnapshot& frame = frames.writeBuffer();
+        if (!traceReader.read(target, frame)) {
+            fprintf(stderr, "Corrupt trace frame %lu\n", static_cast<unsigned long>(target));
+            break;
+        }
+        // Interpolujemy tylko przy odtwarzaniu do przodu po kolei
+        bool sequential = shown != SIZE_MAX && target == shown + 1;
+        if (!sequential) {
+            frame.prevX.assign(frame.x.begin(), frame.x.end());
+            frame.prevY.assign(frame.y.begin(), frame.y.end());
+            frame.prevObstacles.assign(frame.obstacles.begin(), frame.obstacles.end());
         }
+        frame.publishedAt = now;
+        frame.tickSeconds = (sequential && speed > 0.0f) ? tickSeconds / speed : 0.0f;
+        frames.publish();
+        shown = target;
     }
 }
 
-
-// Metoda rysujca pik
-void Ball::draw() {
-    glColor3f(colorR, colorG, colorB);
-    glTranslatef(x, y, 0.0f);
-    glutSolidSphere(radius, 20, 20);
+// Funkcja rysujca k-ty GrayObs
+void drawObstacle(const FrameSnapshot& frame, size_t k, float alpha) {
+    const ObsRect& rect = frame.obstacles[k];
+    const ObsRect& prev = frame.prevObstacles[k];
+    glColor3f(frame.obsColorR[k], frame.obsColorG[k], frame.obsColorB[k]);
+    glTranslatef(prev.x + (rect.x - prev.x) * alpha, prev.y + (rect.y - prev.y) * alpha, 0.0f);
+    glBegin(GL_QUADS);
+    glVertex2f(0.0f, 0.0f);
+    glVertex2f(rect.width, 0.0f);
+    glVertex2f(rect.width, rect.height);
+    glVertex2f(0.0f, rect.height);
+    glEnd();
 }
 
-// Funkcja wywietlajca
+// Funkcja wywietlajca - czyta ostatni opublikowan klatk, nie blokuje fizyki
 void display() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (lastDisplay.time_since_epoch().count() != 0) {
+        metrics().record(HIST_FRAME, std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastDisplay).count());
+    }
+    lastDisplay = now;
+    ScopedLatency timer(HIST_DISPLAY);
+    ScopedTraceEvent event("display");
     glClear(GL_COLOR_BUFFER_BIT);
 
-    std::lock_guard<std::mutex> lock(mutex);
-    balls.erase(std::remove_if(balls.begin(), balls.end(),
-                               [](const std::unique_ptr<Ball>& b) { return !b->active; }),
-                balls.end());
-
-    for (auto& ball : balls) {
+    frames.update();
+    const FrameSnapshot& frame = frames.readBuffer();
+    float alpha = frame.interpolation(now);
+    {
+        ScopedTraceEvent drawEvent("draw balls");
         glLoadIdentity();
-        ball->draw();
+        ballRenderer.draw(frame, alpha);
     }
 
-    glLoadIdentity();
-    grayObs.update();
-    grayObs.draw();
+    {
+        ScopedTraceEvent drawEvent("draw GrayObs");
+        for (size_t k = 0; k < frame.obstacles.size(); k++) {
+            glLoadIdentity();
+            drawObstacle(frame, k, alpha);
+        }
+    }
 
-    glutSwapBuffers();
+    hud.frame(frame, now);
+    hud.draw();
+
+    {
+        ScopedTraceEvent swapEvent("glutSwapBuffers");
+        glutSwapBuffers();
+    }
+
+    MetricGauges gauges = { frame.tick, frame.size(), frame.attachedCount, frame.workers };
+    metrics().count(COUNTER_FRAMES);
+    metrics().sample(gauges);
 }
 
 // Funkcja inicjalizujca OpenGL
-void initGL() {
+void initGL(bool allowInstancing) {
     glClearColor(0.7f, 0.7f, 1.0f, 1.0f);
+    ballRenderer.init(allowInstancing);
+    printf("Renderer: %s\n", ballRenderer.modeName());
 }
 
 // Funkcja obsugujca nacinicia klawiszy
@@ -209,65 +280,202 @@ void keyboard(unsigned char key, int x, int y) {
     if (key == 32) { // Spacja
         running = false;
         ballCond.notify_all();
-        for (auto& thread : ballThreads) {
-            if (thread.joinable()) {
-                thread.join();
+        if (physicsThread.joinable()) {
+            physicsThread.join();
+        }
+        if (sim && savePath) {
+            if (sim->saveCheckpoint(savePath)) {
+                printf("State saved to %s (%lu balls)\n", savePath, static_cast<unsigned long>(sim->balls().size()));
+            } else {
+                fprintf(stderr, "Cannot save checkpoint %s\n", savePath);
+            }
+        }
+        if (recording) {
+            traceWriter.close();
+            printf("Trace: %llu frames, %llu bytes\n", static_cast<unsigned long long>(traceWriter.framesWritten()),
+                   static_cast<unsigned long long>(traceWriter.bytesWritten()));
+        }
+        if (sim) {
+            ThreadStats threads = sim->threadStats();
+            printf("Worker threads: %u live, %llu started, %llu retired\n", threads.live, threads.started, threads.retired);
+        }
+        if (metricsPath) exportMetrics(metricsPath);
+        if (profilePath) {
+            if (writeChromeTrace(profilePath)) {
+                printf("Timeline written to %s\n", profilePath);
+            } else {
+                fprintf(stderr, "Cannot write timeline %s\n", profilePath);
             }
         }
         exit(0);
     }
-}
-
-// Funkcja zarzdzajca pikami
-void manageBalls() {
-    while (running) {
-        std::unique_lock<std::mutex> lock(mutex);
-        auto nextBallTime = lastBallTime + std::chrono::milliseconds(2000 + rand() % 8000);
-        if (ballCond.wait_until(lock, nextBallTime, [] { return !running; })) {
-            break; // Wyjcie, jeli running jest false
+    if (key == 'm') {
+        exportMetrics(metricsPath ? metricsPath : "metrics");
+        return;
+    }
+    if (key == 'h') {
+        hud.toggle();
+        return;
+    }
+    if (!replaying) {
+        // Tempo symulacji: - i + zmieniaj je dwukrotnie, f przecza tryb najszybszy. Tempo jest atomowe;
+        // mutex bierzemy tylko na chwil, eby wtek fizyki nie przegapi obudzenia
+        double scale = timeScale.load();
+        if (key == '-') {
+            scale = std::max(scale * 0.5, MIN_TIME_SCALE);
+        } else if (key == '+' || key == '=') {
+            scale = std::min(scale * 2.0, MAX_TIME_SCALE);
+        } else if (key == 'f') {
+            fastForward = !fastForward;
+        } else {
+            return;
         }
-        if (running) {
-            std::unique_ptr<Ball> ball(new Ball());
-            ballThreads.emplace_back(&Ball::run, ball.get());
-            balls.push_back(std::move(ball));
-            lastBallTime = std::chrono::steady_clock::now();
+        timeScale = scale;
+        {
+            std::unique_lock<std::mutex> lock = lockMutex();
+            paceChanged = true;
         }
+        ballCond.notify_all();
+        printf("Time scale: x%g%s\n", scale, fastForward ? ", fast forward" : "");
+        return;
+    }
+    // Sterowanie odtwarzaniem: p - pauza, [ ] - prdko, , . - klatka wstecz / naprzd
+    if (key != 'p' && key != '[' && key != ']' && key != ',' && key != '.') return;
+    std::unique_lock<std::mutex> lock = lockMutex();
+    if (key == 'p') {
+        replayPaused = !replayPaused;
+    } else if (key == '[') {
+        replaySpeed *= 0.5;
+    } else if (key == ']') {
+        replaySpeed *= 2.0;
+    } else if (key == ',') {
+        replayPaused = true;
+        replayPosition = std::floor(replayPosition) - 1.0;
+    } else if (key == '.') {
+        replayPaused = true;
+        replayPosition = std::floor(replayPosition) + 1.0;
     }
 }
 
 // Funkcja aktualizujca ekran
 void update(int value) {
     glutPostRedisplay();
-    glutTimerFunc(refreshMillis, update, 0);
+    glutTimerFunc(fastForward ? FAST_FRAME_MILLIS : refreshMillis, update, 0);
 }
 
 // Funkcja gwna
 int main(int argc, char **argv) {
+    // Tryb bez okna - nie inicjalizujemy GLUT
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            return runHeadless(argc, argv);
+        }
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
     glutInitWindowSize(1000, 1000);
     glutCreateWindow("Bouncing Balls");
 
-    initGL();
+    // Najwiksza liczba wtkw roboczych: --workers N, domylnie liczba rdzeni
+    // Czstotliwo fizyki: --hz N, domylnie 62.5 (krok 16 ms)
+    // Ziarno generatora: --seed N
+    // Liczba GrayObs: --obstacles N, domylnie 1
+    // --no-instancing wymusza rysowanie piek po jednej
+    // --no-ball-collisions wycza zderzenia piek ze sob
+    // --record PLIK nagrywa kady takt, --replay PLIK odtwarza nagranie (prdko: --speed S, ujemna - wstecz)
+    // --load PLIK startuje od zapisanego stanu, --save PLIK zapisuje stan przy wyjciu spacj
+    // --metrics PRZEDROSTEK zapisuje metryki przy wyjciu; klawisz m zapisuje je w dowolnej chwili
+    // --time-scale S mnoy tempo symulacji, --fast liczy bez czekania i rysuje co FAST_FRAME_MILLIS
+    // --profile PLIK zbiera o czasu wtkw i zapisuje j przy wyjciu w formacie Chrome trace
+    SimulationConfig config;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* loadPath = nullptr;
+    bool allowInstancing = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            config.numWorkers = static_cast<unsigned>(atoi(argv[i + 1]));
+        } else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+            double hz = atof(argv[i + 1]);
+            if (hz > 0.0) physicsDt = static_cast<float>(1.0 / hz);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = strtoull(argv[i + 1], nullptr, 10);
+        } else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+            config.numObstacles = static_cast<unsigned>(strtoul(argv[i + 1], nullptr, 10));
+        } else if (strcmp(argv[i], "--no-instancing") == 0) {
+            allowInstancing = false;
+        } else if (strcmp(argv[i], "--events") == 0) {
+            config.eventDriven = true;
+        } else if (strcmp(argv[i], "--no-ball-collisions") == 0) {
+            config.ballCollisions = false;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            loadPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[i + 1];
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[i + 1];
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            replaySpeed = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+            double scale = atof(argv[i + 1]);
+            if (scale > 0.0) timeScale = std::min(std::max(scale, MIN_TIME_SCALE), MAX_TIME_SCALE);
+        } else if (strcmp(argv[i], "--fast") == 0) {
+            fastForward = true;
+        }
+    }
+
+    setTraceThreadName("GUI");
+    if (profilePath) enableTraceEvents();
+    initGL(allowInstancing);
     glutDisplayFunc(display);
     glutTimerFunc(0, update, 0);
     glutKeyboardFunc(keyboard);
 
-    std::thread managerThread(manageBalls);
+    if (replayPath) {
+        if (!traceReader.open(replayPath)) {
+            fprintf(stderr, "Cannot read trace %s\n", replayPath);
+            return 1;
+        }
+        printf("Replaying %s: %lu frames\n", replayPath, static_cast<unsigned long>(traceReader.numFrames()));
+        replaying = true;
+        if (replaySpeed < 0.0) replayPosition = static_cast<double>(traceReader.numFrames() - 1);
+        physicsThread = std::thread(replayFrames);
+    } else {
+        sim.reset(new Simulation(config));
+        if (loadPath) {
+            if (!sim->loadCheckpoint(loadPath)) {
+                fprintf(stderr, "Cannot load checkpoint %s\n", loadPath);
+                return 1;
+            }
+            printf("Loaded %s: %lu balls, tick %llu\n", loadPath, static_cast<unsigned long>(sim->balls().size()),
+                   sim->tickCount());
+        }
+        if (recordPath) {
+            if (!traceWriter.open(recordPath, physicsDt, sim->random().seed())) {
+                fprintf(stderr, "Cannot write trace %s\n", recordPath);
+                return 1;
+            }
+            recording = true;
+        }
+        physicsThread = std::thread(simulateBalls);
+    }
 
     glutMainLoop();
 
     running = false;
     ballCond.notify_all();
-    if (managerThread.joinable()) {
-        managerThread.join();
-    }
-    for (auto& thread : ballThreads) {
-        if (thread.joinable()) {
-            thread.join();
-        }
+    if (physicsThread.joinable()) {
+        physicsThread.join();
     }
+    if (recording) traceWriter.close();
+    sim.reset();
 
     return 0;
 }
-
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Plik zmapowany do pamici tylko do odczytu (mmap, na Windows CreateFileMapping).
+// Dane s wczytywane przez system dopiero przy pierwszym dostpie do strony.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const uint8_t* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "metrics.h"
+
+#include <cstdio>
+#include <cstring>
+
+const unsigned LatencyHistogram::SUB_BITS;
+const unsigned LatencyHistogram::SUB_BUCKETS;
+const unsigned LatencyHistogram::NUM_BUCKETS;
+const size_t MetricsRegistry::MAX_SAMPLES;
+
+static const char* const COUNTER_NAMES[NUM_COUNTERS] = {
+    "ticks", "frames", "balls_spawned", "balls_retired", "attach_events", "repel_events", "contacts"
+};
+
+static const char* const HISTOGRAM_NAMES[NUM_HISTOGRAMS] = {
+    "step_ns", "display_ns", "frame_ns", "lock_wait_ns"
+};
+
+const char* metricName(MetricCounter c) {
+    return COUNTER_NAMES[c];
+}
+
+const char* metricName(MetricHistogram h) {
+    return HISTOGRAM_NAMES[h];
+}
+
+void LatencyHistogram::clear() {
+    count = 0;
+    sum = 0;
+    max = 0;
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+    for (unsigned b = 0; b < NUM_BUCKETS; b++) {
+        buckets[b] += other.buckets[b];
+    }
+}
+
+unsigned LatencyHistogram::bucketOf(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<unsigned>(value);
+    unsigned exponent = 63 - __builtin_clzll(value);
+    unsigned sub = static_cast<unsigned>(value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(unsigned bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    unsigned shift = bucket / SUB_BUCKETS - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < NUM_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketUpperBound(b), max);
+    }
+    return max;
+}
+
+MetricsRegistry::ThreadMetrics::ThreadMetrics() {
+    for (int c = 0; c < NUM_COUNTERS; c++) counters[c].store(0, std::memory_order_relaxed);
+    for (int h = 0; h < NUM_HISTOGRAMS; h++) {
+        histCount[h].store(0, std::memory_order_relaxed);
+        histSum[h].store(0, std::memory_order_relaxed);
+        histMax[h].store(0, std::memory_order_relaxed);
+        for (unsigned b = 0; b < LatencyHistogram::NUM_BUCKETS; b++) {
+            buckets[h][b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+MetricsRegistry::MetricsRegistry()
+    : created(std::chrono::steady_clock::now()), samplesTaken(0) {}
+
+MetricsRegistry::ThreadMetrics& MetricsRegistry::local() {
+    // Blok jest tworzony przy pierwszym pomiarze w danym wtku i zostaje w rejestrze po kocu wtku
+    static thread_local ThreadMetrics* block = nullptr;
+    static thread_local const MetricsRegistry* owner = nullptr;
+    if (owner != this) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.emplace_back(new ThreadMetrics);
+        block = threads.back().get();
+        owner = this;
+    }
+    return *block;
+}
+
+uint64_t MetricsRegistry::total(MetricCounter c) const {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    uint64_t sum = 0;
+    for (size_t t = 0; t < threads.size(); t++) {
+        sum += threads[t]->counters[c].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void MetricsRegistry::histogram(MetricHistogram h, LatencyHistogram& out) const {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    out.clear();
+    for (size_t t = 0; t < threads.size(); t++) {
+        const ThreadMetrics& block = *threads[t];
+        out.count += block.histCount[h].load(std::memory_order_relaxed);
+        out.sum += block.histSum[h].load(std::memory_order_relaxed);
+        out.max = std::max(out.max, block.histMax[h].load(std::memory_order_relaxed));
+        for (unsigned b = 0; b < LatencyHistogram::NUM_BUCKETS; b++) {
+            out.buckets[b] += block.buckets[h][b].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void MetricsRegistry::sample(const MetricGauges& gauges) {
+    if (samples.empty()) samples.resize(MAX_SAMPLES);
+    MetricSample& s = samples[samplesTaken % MAX_SAMPLES];
+    s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+    s.gauges = gauges;
+    memset(s.counters, 0, sizeof(s.counters));
+    memset(s.histCount, 0, sizeof(s.histCount));
+    memset(s.histSum, 0, sizeof(s.histSum));
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (size_t t = 0; t < threads.size(); t++) {
+            const ThreadMetrics& block = *threads[t];
+            for (int c = 0; c < NUM_COUNTERS; c++) {
+                s.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+            }
+            for (int h = 0; h < NUM_HISTOGRAMS; h++) {
+                s.histCount[h] += block.histCount[h].load(std::memory_order_relaxed);
+                s.histSum[h] += block.histSum[h].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    samplesTaken++;
+}
+
+bool MetricsRegistry::writeCsv(const char* path) const {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "seconds,tick,balls,attached,workers");
+    for (int c = 0; c < NUM_COUNTERS; c++) fprintf(out, ",%s", COUNTER_NAMES[c]);
+    // Dla histogramw: liczba pomiarw i redni czas od poprzedniej prbki
+    for (int h = 0; h < NUM_HISTOGRAMS; h++) fprintf(out, ",%s_count,%s_mean", HISTOGRAM_NAMES[h], HISTOGRAM_NAMES[h]);
+    fprintf(out, "\n");
+
+    size_t n = numSamples();
+    for (size_t age = n; age-- > 0;) {
+        const MetricSample& s = recentSample(age);
+        const MetricSample* prev = age + 1 < n ? &recentSample(age + 1) : nullptr;
+        fprintf(out, "%.6f,%llu,%lu,%lu,%u", s.seconds, s.gauges.tick, static_cast<unsigned long>(s.gauges.balls),
+                static_cast<unsigned long>(s.gauges.attached), s.gauges.workers);
+        for (int c = 0; c < NUM_COUNTERS; c++) {
+            fprintf(out, ",%llu", static_cast<unsigned long long>(s.counters[c]));
+        }
+        for (int h = 0; h < NUM_HISTOGRAMS; h++) {
+            uint64_t count = s.histCount[h] - (prev ? prev->histCount[h] : 0);
+            uint64_t sum = s.histSum[h] - (prev ? prev->histSum[h] : 0);
+            fprintf(out, ",%llu,%.0f", static_cast<unsigned long long>(count), count ? static_cast<double>(sum) / count : 0.0);
+        }
+        fprintf(out, "\n");
+    }
+    return fclose(out) == 0;
+}
+
+bool MetricsRegistry::writeJson(const char* path) const {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "{\n  \"counters\": {\n");
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        fprintf(out, "    \"%s\": %llu%s\n", COUNTER_NAMES[c],
+                static_cast<unsigned long long>(total(static_cast<MetricCounter>(c))), c + 1 < NUM_COUNTERS ? "," : "");
+    }
+    fprintf(out, "  },\n  \"histograms\": {\n");
+    LatencyHistogram hist;
+    for (int h = 0; h < NUM_HISTOGRAMS; h++) {
+        histogram(static_cast<MetricHistogram>(h), hist);
+        fprintf(out, "    \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, "
+                     "\"p999\": %llu, \"max\": %llu}%s\n",
+                HISTOGRAM_NAMES[h], static_cast<unsigned long long>(hist.count),
+                hist.count ? static_cast<double>(hist.sum) / hist.count : 0.0,
+                static_cast<unsigned long long>(hist.percentile(0.5)), static_cast<unsigned long long>(hist.percentile(0.9)),
+                static_cast<unsigned long long>(hist.percentile(0.99)), static_cast<unsigned long long>(hist.percentile(0.999)),
+                static_cast<unsigned long long>(hist.max), h + 1 < NUM_HISTOGRAMS ? "," : "");
+    }
+    fprintf(out, "  },\n  \"samples\": %lu\n}\n", static_cast<unsigned long>(numSamples()));
+    return fclose(out) == 0;
+}
+
+MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
@@ -0,0 +1,162 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Liczniki zdarze
+enum MetricCounter {
+    COUNTER_TICKS,            // Kroki fizyki
+    COUNTER_FRAMES,           // Narysowane klatki
+    COUNTER_BALLS_SPAWNED,
+    COUNTER_BALLS_RETIRED,    // Piki usunite po przekroczeniu limitu odbi
+    COUNTER_ATTACHED,         // Przyklejenia do GrayObs
+    COUNTER_REPELLED,         // Piki odepchnite przez GrayObs
+    COUNTER_CONTACTS,         // Zderzenia piek
+    NUM_COUNTERS
+};
+
+// Histogramy czasw w nanosekundach
+enum MetricHistogram {
+    HIST_STEP,         // Simulation::step
+    HIST_DISPLAY,      // display()
+    HIST_FRAME,        // Odstp midzy kolejnymi wywoaniami display()
+    HIST_LOCK_WAIT,    // Czekanie na globalny mutex w main.cpp
+    NUM_HISTOGRAMS
+};
+
+const char* metricName(MetricCounter c);
+const char* metricName(MetricHistogram h);
+
+// Histogram logarytmiczno-liniowy w stylu HDR: kada potga dwjki jest podzielona na 16 rwnych
+// przedziaw, wic bd wzgldny odczytanego percentyla nie przekracza 1/16 w caym zakresie
+// od nanosekund do minut, a dodanie wartoci to kilka operacji bitowych.
+class LatencyHistogram {
+public:
+    static const unsigned SUB_BITS = 4;
+    static const unsigned SUB_BUCKETS = 1u << SUB_BITS;
+    static const unsigned NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { clear(); }
+
+    void clear();
+    void add(uint64_t value) {
+        buckets[bucketOf(value)]++;
+        count++;
+        sum += value;
+        if (value > max) max = value;
+    }
+    void merge(const LatencyHistogram& other);
+
+    // Warto, poniej ktrej ley uamek q (0..1) wartoci; grna granica przedziau
+    uint64_t percentile(double q) const;
+
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[NUM_BUCKETS];
+
+    static unsigned bucketOf(uint64_t value);
+    static uint64_t bucketUpperBound(unsigned bucket);
+};
+
+// Wielkoci odczytywane przy prbkowaniu, ktrych rejestr sam nie liczy
+struct MetricGauges {
+    unsigned long long tick;
+    size_t balls;
+    size_t attached;
+    unsigned workers;
+};
+
+// Jedna prbka - stan licznikw w chwili wywoania sample()
+struct MetricSample {
+    double seconds;   // Od utworzenia rejestru
+    MetricGauges gauges;
+    uint64_t counters[NUM_COUNTERS];
+    uint64_t histCount[NUM_HISTOGRAMS];
+    uint64_t histSum[NUM_HISTOGRAMS];
+};
+
+// Rejestr metryk. Kady wtek pisze do wasnego bloku licznikw (bez blokad i bez wspdzielenia
+// linii pamici podrcznej); odczyt sumuje bloki wszystkich wtkw, take tych ju zakoczonych.
+// Prbki s trzymane w buforze cyklicznym o staym rozmiarze (zajmowanym przy pierwszej prbce),
+// wic kolejne wywoania sample() nie alokuj pamici.
+class MetricsRegistry {
+public:
+    static const size_t MAX_SAMPLES = 1 << 15;
+
+    MetricsRegistry();
+
+    void count(MetricCounter c, uint64_t n = 1) {
+        bump(local().counters[c], n);
+    }
+
+    void record(MetricHistogram h, uint64_t ns) {
+        ThreadMetrics& t = local();
+        bump(t.buckets[h][LatencyHistogram::bucketOf(ns)], 1);
+        bump(t.histCount[h], 1);
+        bump(t.histSum[h], ns);
+        if (ns > t.histMax[h].load(std::memory_order_relaxed)) t.histMax[h].store(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t total(MetricCounter c) const;
+    void histogram(MetricHistogram h, LatencyHistogram& out) const;
+
+    // Zapisuje prbk; wywoywane przez jeden wtek (co klatk albo co takt)
+    void sample(const MetricGauges& gauges);
+    size_t numSamples() const { return std::min(samplesTaken, MAX_SAMPLES); }
+    const MetricSample& recentSample(size_t age) const { return samples[(samplesTaken - 1 - age) % MAX_SAMPLES]; }
+
+    // Eksport: CSV z prbkami, JSON z sumami licznikw i percentylami histogramw
+    bool writeCsv(const char* path) const;
+    bool writeJson(const char* path) const;
+
+private:
+    // Osobna alokacja na wtek - bloki rnych wtkw nie dziel linii pamici podrcznej
+    struct ThreadMetrics {
+        ThreadMetrics();
+        std::atomic<uint64_t> counters[NUM_COUNTERS];
+        std::atomic<uint64_t> histCount[NUM_HISTOGRAMS];
+        std::atomic<uint64_t> histSum[NUM_HISTOGRAMS];
+        std::atomic<uint64_t> histMax[NUM_HISTOGRAMS];
+        std::atomic<uint64_t> buckets[NUM_HISTOGRAMS][LatencyHistogram::NUM_BUCKETS];
+    };
+
+    // Tylko wtek-waciciel pisze do swojego bloku, wic wystarczy odczyt i zapis bez lock-prefiksu
+    static void bump(std::atomic<uint64_t>& v, uint64_t n) {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    ThreadMetrics& local();
+
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+    std::chrono::steady_clock::time_point created;
+    std::vector<MetricSample> samples;
+    size_t samplesTaken;
+};
+
+// Wsplny rejestr programu
+MetricsRegistry& metrics();
+
+// Mierzy czas od konstrukcji do koca zasigu
+class ScopedLatency {
+public:
+    explicit ScopedLatency(MetricHistogram h) : hist(h), start(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        metrics().record(hist, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start).count()));
+    }
+
+private:
+    MetricHistogram hist;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
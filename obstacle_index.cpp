@@ -0,0 +1,106 @@
+#include "obstacle_index.h"
+
+#include <algorithm>
+#include <limits>
+
+ObstacleIndex::ObstacleIndex() : maxWidth(0.0f) {
+    // Prostokt poza wiatem - adna pika go nie dotknie
+    ObsRect none = { 1e30f, 1e30f, 0.0f, 0.0f };
+    all = none;
+}
+
+void ObstacleIndex::update(const std::vector<ObsRect>& obstacles, const std::vector<float>& obstacleShifts) {
+    rects = obstacles;
+    shifts = obstacleShifts;
+    size_t n = rects.size();
+    if (order.size() != n) {
+        order.resize(n);
+        for (size_t k = 0; k < n; k++) order[k] = static_cast<uint32_t>(k);
+    }
+
+    // Sortowanie przez wstawianie wedug (lewa krawd, numer) - przy remisie decyduje numer,
+    // eby wynik nie zalea od historii
+    for (size_t a = 1; a < n; a++) {
+        uint32_t k = order[a];
+        float key = rects[k].x;
+        size_t b = a;
+        while (b > 0 && (rects[order[b - 1]].x > key || (rects[order[b - 1]].x == key && order[b - 1] > k))) {
+            order[b] = order[b - 1];
+            b--;
+        }
+        order[b] = k;
+    }
+
+    minX.resize(n);
+    maxWidth = 0.0f;
+    if (n == 0) {
+        ObsRect none = { 1e30f, 1e30f, 0.0f, 0.0f };
+        all = none;
+        return;
+    }
+    float x0 = rects[0].x, y0 = rects[0].y;
+    float x1 = x0 + rects[0].width, y1 = y0 + rects[0].height;
+    for (size_t a = 0; a < n; a++) {
+        const ObsRect& r = rects[order[a]];
+        float s = shifts[order[a]];
+        minX[a] = r.x;
+        maxWidth = std::max(maxWidth, r.width);
+        x0 = std::min(x0, r.x);
+        y0 = std::min(y0, r.y + std::min(s, 0.0f));
+        x1 = std::max(x1, r.x + r.width);
+        y1 = std::max(y1, r.y + r.height + std::max(s, 0.0f));
+    }
+    ObsRect bounds = { x0, y0, x1 - x0, y1 - y0 };
+    all = bounds;
+}
+
+// Przedzia czasu (od chwili 0), w ktrym punkt p + v * t ley cile midzy lo i hi
+static bool slab(float p, float v, float lo, float hi, float& enter, float& leave) {
+    if (v == 0.0f) {
+        enter = -std::numeric_limits<float>::infinity();
+        leave = std::numeric_limits<float>::infinity();
+        return p > lo && p < hi;
+    }
+    enter = (lo - p) / v;
+    leave = (hi - p) / v;
+    if (enter > leave) std::swap(enter, leave);
+    return true;
+}
+
+int ObstacleIndex::sweep(float x, float y, float dx, float dy, float r, float t0, float t1, float& hitTime) const {
+    // Lewa krawd trafionej przeszkody ley w (xMin - r - maxWidth, xMax + r)
+    float xEnd = x + dx * (t1 - t0);
+    size_t first = std::upper_bound(minX.begin(), minX.end(), std::min(x, xEnd) - r - maxWidth) - minX.begin();
+    size_t last = std::lower_bound(minX.begin(), minX.end(), std::max(x, xEnd) + r) - minX.begin();
+    float yEnd = y + dy * (t1 - t0);
+    float xLo = std::min(x, xEnd);
+    float yLo = std::min(y, yEnd);
+    float yHi = std::max(y, yEnd);
+    int hit = -1;
+    float best = t1 - t0;
+    for (size_t a = first; a < last && best > 0.0f; a++) {
+        uint32_t k = order[a];
+        const ObsRect& obs = rects[k];
+        // Najpierw tani test prostoktw obejmujcych drog koa i przeszkody w tym przedziale czasu
+        float s0 = shifts[k] * t0;
+        float s1 = shifts[k] * t1;
+        if (xLo >= obs.x + obs.width + r || yHi <= obs.y - r + std::min(s0, s1) ||
+            yLo >= obs.y + obs.height + r + std::max(s0, s1)) {
+            continue;
+        }
+        // Ruch koa wzgldem przeszkody, od chwili t0
+        float relY = y - (obs.y + s0);
+        float relDy = dy - shifts[k];
+        float enterX, leaveX, enterY, leaveY;
+        if (!slab(x, dx, obs.x - r, obs.x + obs.width + r, enterX, leaveX)) continue;
+        if (!slab(relY, relDy, -r, obs.height + r, enterY, leaveY)) continue;
+        float enter = std::max(std::max(enterX, enterY), 0.0f);
+        float leave = std::min(leaveX, leaveY);
+        if (enter < leave && enter < best) {
+            hit = static_cast<int>(k);
+            best = enter;
+        }
+    }
+    hitTime = t0 + best;
+    return hit;
+}
@@ -0,0 +1,45 @@
+#ifndef OBSTACLE_INDEX_H
+#define OBSTACLE_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ball_store.h"
+
+// Faza szeroka dla GrayObs - sortowanie i przegldanie wzdu osi X (sweep and prune).
+// Przeszkody s trzymane posortowane wedug lewej krawdzi; zapytanie wyszukuje binarnie zakres,
+// w ktrym lewa krawd moe lee, i sprawdza tylko te przeszkody.
+// GrayObs poruszaj si pionowo, wic kolejno prawie si nie zmienia i sortowanie
+// przez wstawianie od kolejnoci z poprzedniego taktu jest liniowe.
+class ObstacleIndex {
+public:
+    ObstacleIndex();
+
+    // Przebudowuje indeks dla prostoktw przeszkd z pocztku taktu; shifts to przesunicie
+    // kadej przeszkody w pionie do koca taktu (w trakcie taktu przeszkoda porusza si jednostajnie)
+    void update(const std::vector<ObsRect>& obstacles, const std::vector<float>& shifts);
+
+    size_t size() const { return rects.size(); }
+    const ObsRect& rect(size_t k) const { return rects[k]; }
+    float shift(size_t k) const { return shifts[k]; }
+
+    // Prostokt obejmujcy wszystkie przeszkody przez cay takt; bez przeszkd ley poza wiatem
+    const ObsRect& bounds() const { return all; }
+
+    // Test cigy: koo o promieniu r, ktre w chwili t0 (uamek taktu) jest w punkcie (x, y)
+    // i przesuwa si o (dx, dy) na cay takt, a do chwili t1. Zwraca przeszkod, na ktr koo
+    // nachodzi najwczeniej (przy remisie pierwsz wedug lewej krawdzi), albo -1; hitTime to chwila
+    // pierwszego kontaktu. Kontakt to ten sam test co w kernelu - prostokt poszerzony o r.
+    int sweep(float x, float y, float dx, float dy, float r, float t0, float t1, float& hitTime) const;
+
+private:
+    std::vector<ObsRect> rects;    // Wedug numeru przeszkody
+    std::vector<float> shifts;     // Wedug numeru przeszkody
+    std::vector<uint32_t> order;   // Numery przeszkd posortowane wedug lewej krawdzi
+    std::vector<float> minX;       // Lewe krawdzie w kolejnoci order
+    float maxWidth;
+    ObsRect all;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "phase_barrier.h"
+
+#include <chrono>
+#include <thread>
+
+// Tyle czekajcy krci si przed zaniciem. Przerwy midzy fazami jednego taktu
+// (sortowanie, kompaktowanie, sumy prefiksowe) s zwykle krtsze.
+static const std::chrono::microseconds SPIN_TIME(50);
+
+PhaseBarrier::PhaseBarrier(unsigned numParties)
+    : generation(0), parties(numParties), arrived(0), dropped(0) {}
+
+void PhaseBarrier::arrive(unsigned long gen) {
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 != parties.load(std::memory_order_acquire)) return;
+    // Ostatni wtek - zamyka faz, zanim ktokolwiek dojdzie do nastpnej
+    arrived.store(0, std::memory_order_relaxed);
+    parties.fetch_sub(dropped.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation.store(gen + 1, std::memory_order_release);
+    }
+    cond.notify_all();
+}
+
+void PhaseBarrier::arriveAndWait() {
+    unsigned long gen = generation.load(std::memory_order_acquire);
+    arrive(gen);
+    if (generation.load(std::memory_order_acquire) != gen) return;
+
+    std::chrono::steady_clock::time_point spinEnd = std::chrono::steady_clock::now() + SPIN_TIME;
+    for (unsigned i = 1;; i++) {
+        if (generation.load(std::memory_order_acquire) != gen) return;
+        if (i % 32 == 0 && std::chrono::steady_clock::now() >= spinEnd) break;
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this, gen] { return generation.load(std::memory_order_acquire) != gen; });
+}
+
+void PhaseBarrier::arriveAndDrop() {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    arrive(generation.load(std::memory_order_acquire));
+}
+
+void PhaseBarrier::addParties(unsigned count) {
+    parties.fetch_add(count, std::memory_order_acq_rel);
+}
@@ -0,0 +1,39 @@
+#ifndef PHASE_BARRIER_H
+#define PHASE_BARRIER_H
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Bariera wielokrotnego uytku: wszystkie wtki przechodz do nastpnej fazy razem.
+// Dojcie do bariery to jeden fetch_add; ostatni wtek otwiera nastpn faz i budzi reszt.
+// Czekajcy najpierw krtko krc si w ptli, a dopiero potem zasypiaj na zmiennej warunkowej,
+// wic fazy jednego taktu nastpujce tu po sobie nie usypiaj i nie budz wtkw.
+class PhaseBarrier {
+public:
+    explicit PhaseBarrier(unsigned parties);
+
+    // Dochodzi do bariery i czeka, a dojd pozostae wtki
+    void arriveAndWait();
+
+    // Dochodzi do bariery bez czekania i nie bierze udziau w kolejnych fazach (wtek si koczy)
+    void arriveAndDrop();
+
+    // Dopisuje wtki od biecej fazy. Woa tylko z wtku, ktry jeszcze nie doszed do bariery,
+    // eby faza nie moga si zakoczy w trakcie zmiany.
+    void addParties(unsigned count);
+
+    unsigned long phase() const { return generation.load(std::memory_order_acquire); }
+
+private:
+    void arrive(unsigned long gen);
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<unsigned long> generation;
+    std::atomic<unsigned> parties;
+    std::atomic<unsigned> arrived;
+    std::atomic<unsigned> dropped;   // Wtki wypadajce po biecej fazie
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "random.h"
+
+#include <random>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RANDOM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Stae Philox4x32 (Salmon i in., "Parallel random numbers: as easy as 1, 2, 3")
+static const uint32_t PHILOX_M0 = 0xD2511F53u;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+static const uint32_t PHILOX_W0 = 0x9E3779B9u;
+static const uint32_t PHILOX_W1 = 0xBB67AE85u;
+static const int PHILOX_ROUNDS = 10;
+
+// 24 najstarsze bity -> [0, 1), dokadnie reprezentowalne w float
+static const float TO_UNIT = 1.0f / 16777216.0f;
+
+CounterRng::CounterRng(uint64_t seed) {
+    key[0] = static_cast<uint32_t>(seed);
+    key[1] = static_cast<uint32_t>(seed >> 32);
+}
+
+static void philox(uint32_t c[4], uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c[2];
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1;
+        c[0] = n0;
+        c[1] = static_cast<uint32_t>(p1);
+        c[2] = n2;
+        c[3] = static_cast<uint32_t>(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// Blok b daje losowania 4b .. 4b+3; licznik = (b, strumie, id)
+float CounterRng::uniform(RandomStream stream, uint64_t id, uint32_t n) const {
+    uint32_t c[4] = { n >> 2, static_cast<uint32_t>(stream),
+                      static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32) };
+    philox(c, key[0], key[1]);
+    return (c[n & 3] >> 8) * TO_UNIT;
+}
+
+#ifdef RANDOM_SSE2
+// Iloczyny 32x32 -> 64 bity dla czterech linii: modsze i starsze poowy
+static inline void mulhilo(__m128i a, __m128i m, __m128i& lo, __m128i& hi) {
+    __m128i even = _mm_mul_epu32(a, m);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+    even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));   // lo0 lo2 hi0 hi2
+    odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));     // lo1 lo3 hi1 hi3
+    lo = _mm_unpacklo_epi32(even, odd);
+    hi = _mm_unpackhi_epi32(even, odd);
+}
+
+static inline __m128 toUnit(__m128i v) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 8)), _mm_set1_ps(TO_UNIT));
+}
+#endif
+
+void CounterRng::fill(RandomStream stream, uint64_t id, float* out, size_t count) const {
+    size_t n = 0;
+#ifdef RANDOM_SSE2
+    // Cztery bloki naraz, kada linia wektora to inny blok
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(PHILOX_M1));
+    const __m128i streamV = _mm_set1_epi32(static_cast<int>(stream));
+    const __m128i idLo = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(id)));
+    const __m128i idHi = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(id >> 32)));
+    for (; n + 16 <= count; n += 16) {
+        uint32_t b = static_cast<uint32_t>(n >> 2);
+        __m128i c0 = _mm_setr_epi32(static_cast<int>(b), static_cast<int>(b + 1),
+                                    static_cast<int>(b + 2), static_cast<int>(b + 3));
+        __m128i c1 = streamV, c2 = idLo, c3 = idHi;
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int r = 0; r < PHILOX_ROUNDS; r++) {
+            __m128i lo0, hi0, lo1, hi1;
+            mulhilo(c0, m0, lo0, hi0);
+            mulhilo(c2, m1, lo1, hi1);
+            __m128i k0V = _mm_set1_epi32(static_cast<int>(k0));
+            __m128i k1V = _mm_set1_epi32(static_cast<int>(k1));
+            c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), k0V);
+            c1 = lo1;
+            c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), k1V);
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        // Wiersz i = sowo i czterech blokw; po transpozycji wiersz = jeden blok
+        __m128 r0 = toUnit(c0), r1 = toUnit(c1), r2 = toUnit(c2), r3 = toUnit(c3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(out + n, r0);
+        _mm_storeu_ps(out + n + 4, r1);
+        _mm_storeu_ps(out + n + 8, r2);
+        _mm_storeu_ps(out + n + 12, r3);
+    }
+#endif
+    for (; n < count; n++) {
+        out[n] = uniform(stream, id, static_cast<uint32_t>(n));
+    }
+}
+
+uint64_t randomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
@@ -0,0 +1,43 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Strumienie liczb losowych - kade zastosowanie losuje z wasnego strumienia,
+// wic dodanie losowania w jednym miejscu nie przesuwa wynikw w innych
+enum RandomStream {
+    STREAM_SPAWN = 1,      // Prdko i kolor nowej piki (id = numer piki)
+    STREAM_OBSTACLE,       // Prdko GrayObs (id = numer GrayObs)
+    STREAM_LAYOUT,         // Rozmiar i pooenie dodatkowych GrayObs (id = numer GrayObs)
+    STREAM_REPEL,          // Rozrzut kta przy odpychaniu (id = numer piki)
+    STREAM_SCATTER,        // Rozrzucanie piek w trybie bez okna i w benchmarku
+    STREAM_SPAWN_DELAY     // Odstp do nastpnej piki w spawnScheduled() (id = numer piki)
+};
+
+// Generator licznikowy Philox4x32-10. Liczba losowa jest czyst funkcj klucza (ziarna)
+// i licznika (strumie, identyfikator, numer losowania), wic generator nie ma stanu
+// zmienianego przy losowaniu - wtki mog z niego korzysta bez synchronizacji,
+// a wynik nie zaley od kolejnoci losowa.
+class CounterRng {
+public:
+    explicit CounterRng(uint64_t seed);
+
+    // Liczba z przedziau [0, 1) - n-te losowanie identyfikatora id w strumieniu
+    float uniform(RandomStream stream, uint64_t id, uint32_t n) const;
+
+    // Wypenia out losowaniami 0 .. count-1 identyfikatora id; daje te same liczby co uniform().
+    // Wersja SSE2 liczy cztery bloki Philox naraz.
+    void fill(RandomStream stream, uint64_t id, float* out, size_t count) const;
+
+    // Ziarno, z ktrego powsta klucz
+    uint64_t seed() const { return (static_cast<uint64_t>(key[1]) << 32) | key[0]; }
+
+private:
+    uint32_t key[2];
+};
+
+// Losowe ziarno z std::random_device, gdy uytkownik nie poda wasnego
+uint64_t randomSeed();
+
+#endif
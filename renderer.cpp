@@ -0,0 +1,472 @@
+#include "renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Funkcje OpenGL spoza wersji 1.1 pobierane w czasie dziaania (opengl32 na Windows ich nie eksportuje)
+namespace {
+PFNGLGENBUFFERSPROC genBuffersFn;
+PFNGLBINDBUFFERPROC bindBufferFn;
+PFNGLBUFFERDATAPROC bufferDataFn;
+PFNGLBUFFERSUBDATAPROC bufferSubDataFn;
+PFNGLDELETEBUFFERSPROC deleteBuffersFn;
+PFNGLBUFFERSTORAGEPROC bufferStorageFn;
+PFNGLMAPBUFFERRANGEPROC mapBufferRangeFn;
+PFNGLUNMAPBUFFERPROC unmapBufferFn;
+PFNGLFENCESYNCPROC fenceSyncFn;
+PFNGLCLIENTWAITSYNCPROC clientWaitSyncFn;
+PFNGLDELETESYNCPROC deleteSyncFn;
+PFNGLCREATESHADERPROC createShaderFn;
+PFNGLSHADERSOURCEPROC shaderSourceFn;
+PFNGLCOMPILESHADERPROC compileShaderFn;
+PFNGLGETSHADERIVPROC getShaderivFn;
+PFNGLGETSHADERINFOLOGPROC getShaderInfoLogFn;
+PFNGLDELETESHADERPROC deleteShaderFn;
+PFNGLCREATEPROGRAMPROC createProgramFn;
+PFNGLATTACHSHADERPROC attachShaderFn;
+PFNGLLINKPROGRAMPROC linkProgramFn;
+PFNGLGETPROGRAMIVPROC getProgramivFn;
+PFNGLGETPROGRAMINFOLOGPROC getProgramInfoLogFn;
+PFNGLUSEPROGRAMPROC useProgramFn;
+PFNGLGETATTRIBLOCATIONPROC getAttribLocationFn;
+PFNGLGETUNIFORMLOCATIONPROC getUniformLocationFn;
+PFNGLUNIFORM1FPROC uniform1fFn;
+PFNGLENABLEVERTEXATTRIBARRAYPROC enableVertexAttribArrayFn;
+PFNGLDISABLEVERTEXATTRIBARRAYPROC disableVertexAttribArrayFn;
+PFNGLVERTEXATTRIBPOINTERPROC vertexAttribPointerFn;
+PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisorFn;
+PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstancedFn;
+
+template<typename T>
+bool loadProc(T& fn, const char* name, const char* arbName) {
+    fn = reinterpret_cast<T>(glutGetProcAddress(name));
+    if (!fn && arbName) fn = reinterpret_cast<T>(glutGetProcAddress(arbName));
+    return fn != nullptr;
+}
+
+// Wersja kontekstu OpenGL jako liczba, np. 33 dla 3.3
+int glVersion() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int major = 0, minor = 0;
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2) return 0;
+    return major * 10 + minor;
+}
+
+bool loadInstancing() {
+    if (glVersion() < 33 && !(glutExtensionSupported("GL_ARB_instanced_arrays") &&
+                              glutExtensionSupported("GL_ARB_draw_instanced"))) {
+        return false;
+    }
+    bool ok = true;
+    ok &= loadProc(genBuffersFn, "glGenBuffers", "glGenBuffersARB");
+    ok &= loadProc(bindBufferFn, "glBindBuffer", "glBindBufferARB");
+    ok &= loadProc(bufferDataFn, "glBufferData", "glBufferDataARB");
+    ok &= loadProc(bufferSubDataFn, "glBufferSubData", "glBufferSubDataARB");
+    ok &= loadProc(deleteBuffersFn, "glDeleteBuffers", "glDeleteBuffersARB");
+    ok &= loadProc(createShaderFn, "glCreateShader", nullptr);
+    ok &= loadProc(shaderSourceFn, "glShaderSource", nullptr);
+    ok &= loadProc(compileShaderFn, "glCompileShader", nullptr);
+    ok &= loadProc(getShaderivFn, "glGetShaderiv", nullptr);
+    ok &= loadProc(getShaderInfoLogFn, "glGetShaderInfoLog", nullptr);
+    ok &= loadProc(deleteShaderFn, "glDeleteShader", nullptr);
+    ok &= loadProc(createProgramFn, "glCreateProgram", nullptr);
+    ok &= loadProc(attachShaderFn, "glAttachShader", nullptr);
+    ok &= loadProc(linkProgramFn, "glLinkProgram", nullptr);
+    ok &= loadProc(getProgramivFn, "glGetProgramiv", nullptr);
+    ok &= loadProc(getProgramInfoLogFn, "glGetProgramInfoLog", nullptr);
+    ok &= loadProc(useProgramFn, "glUseProgram", nullptr);
+    ok &= loadProc(getAttribLocationFn, "glGetAttribLocation", nullptr);
+    ok &= loadProc(getUniformLocationFn, "glGetUniformLocation", nullptr);
+    ok &= loadProc(uniform1fFn, "glUniform1f", nullptr);
+    ok &= loadProc(enableVertexAttribArrayFn, "glEnableVertexAttribArray", nullptr);
+    ok &= loadProc(disableVertexAttribArrayFn, "glDisableVertexAttribArray", nullptr);
+    ok &= loadProc(vertexAttribPointerFn, "glVertexAttribPointer", nullptr);
+    ok &= loadProc(vertexAttribDivisorFn, "glVertexAttribDivisor", "glVertexAttribDivisorARB");
+    ok &= loadProc(drawArraysInstancedFn, "glDrawArraysInstanced", "glDrawArraysInstancedARB");
+    return ok;
+}
+
+bool loadPersistentMapping() {
+    if (glVersion() < 44 && !glutExtensionSupported("GL_ARB_buffer_storage")) {
+        return false;
+    }
+    bool ok = true;
+    ok &= loadProc(bufferStorageFn, "glBufferStorage", nullptr);
+    ok &= loadProc(mapBufferRangeFn, "glMapBufferRange", nullptr);
+    ok &= loadProc(unmapBufferFn, "glUnmapBuffer", nullptr);
+    ok &= loadProc(fenceSyncFn, "glFenceSync", nullptr);
+    ok &= loadProc(clientWaitSyncFn, "glClientWaitSync", nullptr);
+    ok &= loadProc(deleteSyncFn, "glDeleteSync", nullptr);
+    return ok;
+}
+
+const char* vertexShaderSource =
+    "#version 120\n"
+    "attribute vec2 corner;\n"
+    "attribute vec3 instance;\n"   // x, y, promie
+    "attribute vec3 color;\n"
+    "varying vec3 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = color;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(instance.xy + corner * instance.z, 0.0, 1.0);\n"
+    "}\n";
+
+const char* fragmentShaderSource =
+    "#version 120\n"
+    "varying vec3 fragColor;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+// Impostor: jeden punkt na pik, rozmiar punktu = rednica w pikselach, rogi odcite w shaderze
+const char* impostorVertexShaderSource =
+    "#version 120\n"
+    "attribute vec3 instance;\n"
+    "attribute vec3 color;\n"
+    "uniform float pixelScale;\n"
+    "varying vec3 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = color;\n"
+    "    gl_PointSize = max(2.0 * instance.z * pixelScale, 1.0);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(instance.xy, 0.0, 1.0);\n"
+    "}\n";
+
+const char* impostorFragmentShaderSource =
+    "#version 120\n"
+    "varying vec3 fragColor;\n"
+    "void main() {\n"
+    "    vec2 d = gl_PointCoord * 2.0 - 1.0;\n"
+    "    if (dot(d, d) > 1.0) discard;\n"
+    "    gl_FragColor = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = createShaderFn(type);
+    shaderSourceFn(shader, 1, &source, nullptr);
+    compileShaderFn(shader);
+    GLint ok = GL_FALSE;
+    getShaderivFn(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        getShaderInfoLogFn(shader, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader compilation failed: %s\n", log);
+        deleteShaderFn(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint linkProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vs || !fs) return 0;
+
+    GLuint program = createProgramFn();
+    attachShaderFn(program, vs);
+    attachShaderFn(program, fs);
+    linkProgramFn(program);
+    deleteShaderFn(vs);
+    deleteShaderFn(fs);
+
+    GLint ok = GL_FALSE;
+    getProgramivFn(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        getProgramInfoLogFn(program, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader linking failed: %s\n", log);
+        return 0;
+    }
+    return program;
+}
+
+// Liczba wartoci float na instancj: x, y, promie, r, g, b
+const size_t INSTANCE_FLOATS = 6;
+const size_t INSTANCE_BYTES = INSTANCE_FLOATS * sizeof(float);
+const float PI = 3.14159265f;
+
+// Piki o promieniu mniejszym ni tyle pikseli s rysowane jako impostory
+const float IMPOSTOR_MAX_PIXELS = 3.0f;
+
+// Poziomy szczegowoci: grna granica promienia w pikselach i liczba bokw koa.
+// Bok wielokta ma wtedy najwyej kilka pikseli, wic rnicy nie wida.
+struct LodLevel {
+    float maxPixelRadius;
+    int segments;
+};
+const LodLevel LOD_LEVELS[BallRenderer::NUM_LODS] = {
+    { 12.0f, 8 },
+    { 40.0f, 16 },
+    { 120.0f, 32 },
+    { 1e30f, 64 }
+};
+// Liczba regionw trwale zmapowanego bufora - CPU pisze do jednego, GPU czyta pozostae
+const unsigned NUM_REGIONS = 3;
+}
+
+BallRenderer::BallRenderer()
+    : mode(MODE_IMMEDIATE), program(0), cornerAttrib(-1), instanceAttrib(-1), colorAttrib(-1),
+      impostorProgram(0), impostorInstanceAttrib(-1), impostorColorAttrib(-1), impostorScaleUniform(-1),
+      meshBuffer(0), instanceBuffer(0), capacity(0), mapped(nullptr), region(0), lastVertices(0) {
+    for (unsigned i = 0; i < NUM_REGIONS; i++) fences[i] = nullptr;
+    for (int i = 0; i < NUM_LODS; i++) {
+        lodFirst[i] = 0;
+        lodCount[i] = 0;
+    }
+}
+
+void BallRenderer::init(bool allowInstancing) {
+    mode = MODE_IMMEDIATE;
+    if (!allowInstancing || !loadInstancing() || !createPrograms()) return;
+    createMesh();
+    genBuffersFn(1, &instanceBuffer);
+    mode = loadPersistentMapping() ? MODE_PERSISTENT : MODE_INSTANCED;
+}
+
+const char* BallRenderer::modeName() const {
+    switch (mode) {
+    case MODE_PERSISTENT: return "instanced, persistent mapping";
+    case MODE_INSTANCED: return "instanced";
+    default: return "immediate";
+    }
+}
+
+bool BallRenderer::createPrograms() {
+    program = linkProgram(vertexShaderSource, fragmentShaderSource);
+    impostorProgram = linkProgram(impostorVertexShaderSource, impostorFragmentShaderSource);
+    if (!program || !impostorProgram) return false;
+
+    cornerAttrib = getAttribLocationFn(program, "corner");
+    instanceAttrib = getAttribLocationFn(program, "instance");
+    colorAttrib = getAttribLocationFn(program, "color");
+    impostorInstanceAttrib = getAttribLocationFn(impostorProgram, "instance");
+    impostorColorAttrib = getAttribLocationFn(impostorProgram, "color");
+    impostorScaleUniform = getUniformLocationFn(impostorProgram, "pixelScale");
+    return cornerAttrib >= 0 && instanceAttrib >= 0 && colorAttrib >= 0 &&
+           impostorInstanceAttrib >= 0 && impostorColorAttrib >= 0;
+}
+
+// Wysya do GPU jednostkowe koa wszystkich poziomw jako wachlarze trjktw - raz, przy starcie
+void BallRenderer::createMesh() {
+    std::vector<float> vertices;
+    for (int level = 0; level < NUM_LODS; level++) {
+        int segments = LOD_LEVELS[level].segments;
+        lodFirst[level] = static_cast<GLint>(vertices.size() / 2);
+        lodCount[level] = segments + 2;
+        vertices.push_back(0.0f);
+        vertices.push_back(0.0f);
+        for (int i = 0; i <= segments; i++) {
+            float angle = 2.0f * PI * i / segments;
+            vertices.push_back(cosf(angle));
+            vertices.push_back(sinf(angle));
+        }
+    }
+    genBuffersFn(1, &meshBuffer);
+    bindBufferFn(GL_ARRAY_BUFFER, meshBuffer);
+    bufferDataFn(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    bindBufferFn(GL_ARRAY_BUFFER, 0);
+}
+
+// Liczba pikseli na jednostk wiata (wiat to kwadrat [-1, 1])
+float BallRenderer::pixelScale() const {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    return 0.5f * static_cast<float>(std::min(viewport[2], viewport[3]));
+}
+
+// Grupa szczegowoci dla piki o danym promieniu w pikselach
+int BallRenderer::bucketFor(float pixelRadius) const {
+    if (pixelRadius < IMPOSTOR_MAX_PIXELS) return 0;
+    int level = 0;
+    while (level + 1 < NUM_LODS && pixelRadius >= LOD_LEVELS[level].maxPixelRadius) level++;
+    return level + 1;
+}
+
+// Zapewnia miejsce na count instancji w kadym regionie (tylko MODE_PERSISTENT)
+void BallRenderer::reserveInstances(size_t count) {
+    if (count <= capacity) return;
+    releaseInstances();
+
+    capacity = 1024;
+    while (capacity < count) capacity *= 2;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(capacity * INSTANCE_BYTES * NUM_REGIONS);
+    genBuffersFn(1, &instanceBuffer);
+    bindBufferFn(GL_ARRAY_BUFFER, instanceBuffer);
+    bufferStorageFn(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+    mapped = static_cast<float*>(mapBufferRangeFn(GL_ARRAY_BUFFER, 0, bytes, flags));
+    bindBufferFn(GL_ARRAY_BUFFER, 0);
+    region = 0;
+}
+
+// Zwalnia trwale zmapowany bufor po zakoczeniu wszystkich rysowa, ktre z niego czytaj
+void BallRenderer::releaseInstances() {
+    for (unsigned i = 0; i < NUM_REGIONS; i++) {
+        if (fences[i]) {
+            clientWaitSyncFn(fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            deleteSyncFn(fences[i]);
+            fences[i] = nullptr;
+        }
+    }
+    if (mapped) {
+        bindBufferFn(GL_ARRAY_BUFFER, instanceBuffer);
+        unmapBufferFn(GL_ARRAY_BUFFER);
+        bindBufferFn(GL_ARRAY_BUFFER, 0);
+        mapped = nullptr;
+    }
+    if (instanceBuffer) {
+        deleteBuffersFn(1, &instanceBuffer);
+        instanceBuffer = 0;
+    }
+}
+
+// Zwraca wskanik do regionu biecej klatki, czekajc a GPU skoczy go czyta
+float* BallRenderer::mapRegion(size_t count) {
+    reserveInstances(count);
+    GLsync& fence = fences[region];
+    if (fence) {
+        GLenum result;
+        do {
+            result = clientWaitSyncFn(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000ull);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        deleteSyncFn(fence);
+        fence = nullptr;
+    }
+    return mapped + region * capacity * INSTANCE_FLOATS;
+}
+
+void BallRenderer::draw(const FrameSnapshot& frame, float alpha) {
+    size_t count = frame.size();
+    float scale = pixelScale();
+    lastVertices = 0;
+    if (mode == MODE_IMMEDIATE) {
+        drawImmediate(frame, alpha, scale);
+        return;
+    }
+    if (count == 0) return;
+
+    // Podzia piek na grupy szczegowoci i pocztek kadej grupy w buforze instancji
+    size_t bucketSize[NUM_BUCKETS] = { 0 };
+    size_t bucketStart[NUM_BUCKETS];
+    ballBucket.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        int bucket = bucketFor(frame.radius[i] * scale);
+        ballBucket[i] = static_cast<unsigned char>(bucket);
+        bucketSize[bucket]++;
+    }
+    size_t next[NUM_BUCKETS];
+    bucketStart[0] = 0;
+    for (int b = 1; b < NUM_BUCKETS; b++) {
+        bucketStart[b] = bucketStart[b - 1] + bucketSize[b - 1];
+    }
+    std::copy(bucketStart, bucketStart + NUM_BUCKETS, next);
+
+    // Dane instancji: przeplecione x, y, promie, r, g, b, pogrupowane wedug szczegowoci
+    float* out;
+    if (mode == MODE_PERSISTENT) {
+        out = mapRegion(count);
+    } else {
+        staging.resize(count * INSTANCE_FLOATS);
+        out = &staging[0];
+    }
+    for (size_t i = 0; i < count; i++) {
+        float* inst = out + next[ballBucket[i]]++ * INSTANCE_FLOATS;
+        inst[0] = frame.prevX[i] + (frame.x[i] - frame.prevX[i]) * alpha;
+        inst[1] = frame.prevY[i] + (frame.y[i] - frame.prevY[i]) * alpha;
+        inst[2] = frame.radius[i];
+        inst[3] = frame.colorR[i];
+        inst[4] = frame.colorG[i];
+        inst[5] = frame.colorB[i];
+    }
+
+    size_t regionOffset = 0;
+    bindBufferFn(GL_ARRAY_BUFFER, instanceBuffer);
+    if (mode == MODE_PERSISTENT) {
+        regionOffset = region * capacity * INSTANCE_BYTES;
+    } else {
+        // Osierocenie starego bufora - sterownik nie musi czeka na poprzedni klatk
+        bufferDataFn(GL_ARRAY_BUFFER, count * INSTANCE_BYTES, nullptr, GL_STREAM_DRAW);
+        bufferSubDataFn(GL_ARRAY_BUFFER, 0, count * INSTANCE_BYTES, out);
+    }
+
+    // Koa: jedno wywoanie instancyjne na poziom szczegowoci
+    useProgramFn(program);
+    vertexAttribDivisorFn(instanceAttrib, 1);
+    vertexAttribDivisorFn(colorAttrib, 1);
+    enableVertexAttribArrayFn(instanceAttrib);
+    enableVertexAttribArrayFn(colorAttrib);
+    enableVertexAttribArrayFn(cornerAttrib);
+    for (int level = 0; level < NUM_LODS; level++) {
+        size_t n = bucketSize[level + 1];
+        if (n == 0) continue;
+        size_t offset = regionOffset + bucketStart[level + 1] * INSTANCE_BYTES;
+        bindBufferFn(GL_ARRAY_BUFFER, instanceBuffer);
+        vertexAttribPointerFn(instanceAttrib, 3, GL_FLOAT, GL_FALSE, INSTANCE_BYTES,
+                              reinterpret_cast<const void*>(offset));
+        vertexAttribPointerFn(colorAttrib, 3, GL_FLOAT, GL_FALSE, INSTANCE_BYTES,
+                              reinterpret_cast<const void*>(offset + 3 * sizeof(float)));
+        bindBufferFn(GL_ARRAY_BUFFER, meshBuffer);
+        vertexAttribPointerFn(cornerAttrib, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        drawArraysInstancedFn(GL_TRIANGLE_FAN, lodFirst[level], lodCount[level], static_cast<GLsizei>(n));
+        lastVertices += n * lodCount[level];
+    }
+    disableVertexAttribArrayFn(cornerAttrib);
+    disableVertexAttribArrayFn(instanceAttrib);
+    disableVertexAttribArrayFn(colorAttrib);
+    vertexAttribDivisorFn(instanceAttrib, 0);
+    vertexAttribDivisorFn(colorAttrib, 0);
+
+    // Impostory: jeden punkt na pik z tego samego bufora instancji
+    if (bucketSize[0] > 0) {
+        size_t offset = regionOffset;
+        useProgramFn(impostorProgram);
+        uniform1fFn(impostorScaleUniform, scale);
+        glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        glEnable(GL_POINT_SPRITE);
+        bindBufferFn(GL_ARRAY_BUFFER, instanceBuffer);
+        vertexAttribPointerFn(impostorInstanceAttrib, 3, GL_FLOAT, GL_FALSE, INSTANCE_BYTES,
+                              reinterpret_cast<const void*>(offset));
+        vertexAttribPointerFn(impostorColorAttrib, 3, GL_FLOAT, GL_FALSE, INSTANCE_BYTES,
+                              reinterpret_cast<const void*>(offset + 3 * sizeof(float)));
+        enableVertexAttribArrayFn(impostorInstanceAttrib);
+        enableVertexAttribArrayFn(impostorColorAttrib);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(bucketSize[0]));
+        disableVertexAttribArrayFn(impostorInstanceAttrib);
+        disableVertexAttribArrayFn(impostorColorAttrib);
+        glDisable(GL_POINT_SPRITE);
+        glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        lastVertices += bucketSize[0];
+    }
+    bindBufferFn(GL_ARRAY_BUFFER, 0);
+    useProgramFn(0);
+
+    if (mode == MODE_PERSISTENT) {
+        fences[region] = fenceSyncFn(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % NUM_REGIONS;
+    }
+}
+
+// Rysowanie po staremu - gdy sterownik nie obsuguje instancjonowania.
+// Take tu liczba poudnikw zaley od rozmiaru piki, a najmniejsze piki s punktami.
+void BallRenderer::drawImmediate(const FrameSnapshot& frame, float alpha, float scale) {
+    for (size_t i = 0; i < frame.size(); i++) {
+        float x = frame.prevX[i] + (frame.x[i] - frame.prevX[i]) * alpha;
+        float y = frame.prevY[i] + (frame.y[i] - frame.prevY[i]) * alpha;
+        float pixelRadius = frame.radius[i] * scale;
+        int bucket = bucketFor(pixelRadius);
+        glLoadIdentity();
+        glColor3f(frame.colorR[i], frame.colorG[i], frame.colorB[i]);
+        if (bucket == 0) {
+            glPointSize(std::max(2.0f * pixelRadius, 1.0f));
+            glBegin(GL_POINTS);
+            glVertex2f(x, y);
+            glEnd();
+            lastVertices += 1;
+        } else {
+            int segments = LOD_LEVELS[bucket - 1].segments;
+            glTranslatef(x, y, 0.0f);
+            glutSolidSphere(frame.radius[i], segments, segments / 2);
+            lastVertices += static_cast<size_t>(segments) * (segments / 2 + 1) * 2;
+        }
+    }
+}
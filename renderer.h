@@ -0,0 +1,66 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <GL/freeglut.h>
+#include <GL/glext.h>
+#include <vector>
+#include <cstddef>
+
+#include "frame_snapshot.h"
+
+// Rysowanie piek wywoaniami instancyjnymi. Siatki koa s wysyane raz,
+// a pozycje, promienie i kolory piek trafiaj do trwale zmapowanego bufora.
+// Liczba bokw koa zaley od promienia piki w pikselach, a bardzo mae piki
+// s rysowane jako pojedyncze punkty (impostory) przycinane w shaderze do koa.
+// Jeli sterownik nie ma potrzebnych rozszerze, piki s rysowane po staremu.
+class BallRenderer {
+public:
+    BallRenderer();
+
+    // Wywoywane po utworzeniu okna; allowInstancing = false wymusza tryb natychmiastowy
+    void init(bool allowInstancing);
+
+    // Rysuje piki w pooeniu prev + (biece - prev) * alpha
+    void draw(const FrameSnapshot& frame, float alpha);
+
+    // Nazwa uywanej cieki rysowania
+    const char* modeName() const;
+
+    // Liczba wierzchokw wysanych w ostatniej klatce
+    size_t verticesDrawn() const { return lastVertices; }
+
+    // Grupy szczegowoci: 0 = impostory, 1..NUM_LODS = koa o rosncej liczbie bokw
+    static const int NUM_LODS = 4;
+    static const int NUM_BUCKETS = NUM_LODS + 1;
+
+private:
+    enum Mode { MODE_IMMEDIATE, MODE_INSTANCED, MODE_PERSISTENT };
+
+    bool createPrograms();
+    int bucketFor(float pixelRadius) const;
+    float pixelScale() const;
+    void createMesh();
+    void reserveInstances(size_t count);
+    void releaseInstances();
+    float* mapRegion(size_t count);
+    void drawImmediate(const FrameSnapshot& frame, float alpha, float scale);
+
+    Mode mode;
+    GLuint program;
+    GLint cornerAttrib, instanceAttrib, colorAttrib;
+    GLuint impostorProgram;
+    GLint impostorInstanceAttrib, impostorColorAttrib, impostorScaleUniform;
+    GLuint meshBuffer;
+    GLint lodFirst[NUM_LODS];    // Pierwszy wierzchoek siatki danego poziomu w meshBuffer
+    GLsizei lodCount[NUM_LODS];  // Liczba wierzchokw siatki danego poziomu
+    GLuint instanceBuffer;
+    size_t capacity;         // Liczba instancji w jednym regionie bufora
+    float* mapped;           // Trwale zmapowany bufor (MODE_PERSISTENT)
+    unsigned region;         // Region, do ktrego piszemy w tej klatce
+    GLsync fences[3];        // Ogrodzenia GPU dla kadego regionu
+    std::vector<float> staging;  // Bufor poredni dla MODE_INSTANCED
+    std::vector<unsigned char> ballBucket;  // Grupa szczegowoci kadej piki w biecej klatce
+    size_t lastVertices;
+};
+
+#endif
@@ -0,0 +1,457 @@
+#include "simulation.h"
+#include "metrics.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Dodatkowy GrayObs o losowym rozmiarze, pooeniu i progu odpychania
+static GrayObs* randomObstacle(uint32_t id, const CounterRng& rng) {
+    float rnd[5];
+    rng.fill(STREAM_LAYOUT, id, rnd, 5);
+    float width = 0.05f + rnd[0] * 0.1f;
+    float height = 0.1f + rnd[1] * 0.2f;
+    float x = -1.0f + rnd[2] * (2.0f - width);
+    float y = -1.0f + rnd[3] * (2.0f - height);
+    size_t repelAfter = 2 + static_cast<size_t>(rnd[4] * 7.0f);
+    return new GrayObs(id, rng, x, y, width, height, repelAfter);
+}
+
+Simulation::Simulation(const SimulationConfig& config)
+    : cfg(config), rng(config.seed ? config.seed : randomSeed()), spawnCount(0), store(cfg.ballCapacity),
+      lastDt(0.0f), moveStep(0.25f), contacts(0), ticks(0), simTime(0.0) {
+    nextSpawnTime = spawnDelay();
+    // Silnik zdarzeniowy nie obsuguje zderze piek
+    if (cfg.eventDriven) cfg.ballCollisions = false;
+    for (unsigned k = 0; k < cfg.numObstacles; k++) {
+        obstacles.emplace_back(k == 0 ? new GrayObs(k, rng) : randomObstacle(k, rng));
+        obsRects.push_back(obstacles.back()->bounds());
+    }
+    obsShifts.assign(obsRects.size(), 0.0f);
+    attachQueue.reserve(store.capacity());
+    retireQueue.reserve(store.capacity());
+    obstacleIndex.update(obsRects, obsShifts);
+    obsRect = obstacleIndex.bounds();
+    scheduleAll();
+
+    maxWorkers = cfg.numWorkers ? cfg.numWorkers : std::thread::hardware_concurrency();
+    pool.reset(new WorkerPool(cfg.adaptiveWorkers ? 1 : maxWorkers));
+    shrinkTicks = 0;
+    stepChunk = [this](size_t begin, size_t end) { stepBalls(begin, end); };
+}
+
+BallHandle Simulation::spawnBall() {
+    return spawnBallAt(0.0f, -1.0f + cfg.ballRadius);
+}
+
+BallHandle Simulation::spawnBallAt(float x, float y) {
+    if (store.size() >= store.capacity()) store.compact();
+    if (store.size() >= store.capacity()) return INVALID_BALL;
+    float rnd[5];
+    rng.fill(STREAM_SPAWN, spawnCount, rnd, 5);
+    metrics().count(COUNTER_BALLS_SPAWNED);
+    BallHandle h = store.spawn(cfg.ballRadius, x, y, spawnCount++, rnd);
+    if (cfg.eventDriven) events.schedule(store, store.size() - 1, simTime);
+    return h;
+}
+
+// Odstp do nastpnej piki harmonogramu: 2-10 s, losowany dla numeru tej piki
+double Simulation::spawnDelay() const {
+    return 2.0 + 8.0 * rng.uniform(STREAM_SPAWN_DELAY, spawnCount, 0);
+}
+
+void Simulation::spawnScheduled() {
+    if (simTime < nextSpawnTime) return;
+    ScopedTraceEvent event("spawn ball");
+    spawnBall();
+    nextSpawnTime = simTime + spawnDelay();
+}
+
+// Metoda przesuwajca porcj piek o jeden takt
+void Simulation::stepBalls(size_t begin, size_t end) {
+    std::copy(store.x.begin() + begin, store.x.begin() + end, store.prevX.begin() + begin);
+    std::copy(store.y.begin() + begin, store.y.begin() + end, store.prevY.begin() + begin);
+    stepKernel(store, begin, end, obsRect, cfg.bounceLimit, moveStep);
+
+    // Zdarzenia s rzadkie, obsugujemy je skalarnie
+    for (size_t i = begin; i < end; i++) {
+        int32_t ev = store.events[i];
+        if (ev & EVENT_EXPIRED) {
+            retireQueue.push(static_cast<uint32_t>(i));
+        } else if (ev & EVENT_SWEEP) {
+            sweepBall(i, ev);
+        } else if ((ev & (EVENT_BOUNCE_X | EVENT_BOUNCE_Y)) && store.numBounces[i] >= cfg.bounceLimit) {
+            // Pika znika w takcie, w ktrym osigna limit odbi, a nie dopiero w nastpnym
+            retireQueue.push(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Liczy takt piki od nowa, odcinkami midzy kolejnymi odbiciami od cian, i sprawdza kady odcinek
+// z GrayObs w sposb cigy. Pika przykleja si w chwili pierwszego kontaktu, w punkcie kontaktu,
+// wic nawet dugi krok nie przenosi jej przez GrayObs ani przez cian.
+void Simulation::sweepBall(size_t i, int32_t ev) {
+    float r = store.radius[i];
+    float lo = r - 1.0f;
+    float hi = 1.0f - r;
+
+    // Uamek taktu, od ktrego pika moe si przyklei
+    double wait = (store.cooldownEnd[i] - simTime) / lastDt;
+    float stickFrom = wait > 0.0 ? static_cast<float>(std::min(wait, 2.0)) : 0.0f;
+    // Pika nie moe si przyklei w tym takcie, a kernel odbi j poprawnie - nie ma czego poprawia
+    if (stickFrom >= 1.0f && std::max(std::fabs(store.x[i]), std::fabs(store.y[i])) <= hi) {
+        if ((ev & (EVENT_BOUNCE_X | EVENT_BOUNCE_Y)) && store.numBounces[i] >= cfg.bounceLimit) {
+            retireQueue.push(static_cast<uint32_t>(i));
+        }
+        return;
+    }
+
+    // Stan z pocztku taktu - kernel zapisa, na ktrych osiach odwrci prdko
+    float x = store.prevX[i];
+    float y = store.prevY[i];
+    float vx = (ev & EVENT_BOUNCE_X) ? -store.xSpeed[i] : store.xSpeed[i];
+    float vy = (ev & EVENT_BOUNCE_Y) ? -store.ySpeed[i] : store.ySpeed[i];
+    int32_t bounces = store.numBounces[i] - ((ev & EVENT_BOUNCE_X) ? 1 : 0) - ((ev & EVENT_BOUNCE_Y) ? 1 : 0);
+
+    float t = 0.0f;
+    for (;;) {
+        float dx = vx * moveStep;
+        float dy = vy * moveStep;
+        float wallX = 1.0f, wallY = 1.0f;
+        if ((dx > 0.0f && x + dx * (1.0f - t) > hi) || (dx < 0.0f && x + dx * (1.0f - t) < lo)) {
+            wallX = t + std::max(((dx > 0.0f ? hi : lo) - x) / dx, 0.0f);
+        }
+        if ((dy > 0.0f && y + dy * (1.0f - t) > hi) || (dy < 0.0f && y + dy * (1.0f - t) < lo)) {
+            wallY = t + std::max(((dy > 0.0f ? hi : lo) - y) / dy, 0.0f);
+        }
+        float until = std::min(std::min(wallX, wallY), 1.0f);
+
+        if (stickFrom < until) {
+            float from = std::max(t, stickFrom);
+            float hitTime;
+            int k = obstacleIndex.sweep(x + dx * (from - t), y + dy * (from - t), dx, dy, r, from, until, hitTime);
+            if (k >= 0) {
+                float hx = x + dx * (hitTime - t);
+                float hy = y + dy * (hitTime - t);
+                store.x[i] = hx;
+                store.y[i] = hy;
+                store.xSpeed[i] = vx;
+                store.ySpeed[i] = vy;
+                store.numBounces[i] = bounces;
+                const ObsRect& rect = obstacleIndex.rect(k);
+                AttachRequest request = { static_cast<uint32_t>(i), static_cast<uint32_t>(k),
+                                          hx - rect.x, hy - (rect.y + obstacleIndex.shift(k) * hitTime) };
+                attachQueue.push(request);
+                return;
+            }
+        }
+
+        x += dx * (until - t);
+        y += dy * (until - t);
+        t = until;
+        if (t >= 1.0f) break;
+        if (wallX == until) {
+            x = dx > 0.0f ? hi : lo;
+            vx = -vx;
+            bounces++;
+        }
+        if (wallY == until) {
+            y = dy > 0.0f ? hi : lo;
+            vy = -vy;
+            bounces++;
+        }
+        if (bounces >= cfg.bounceLimit) {
+            retireQueue.push(static_cast<uint32_t>(i));
+            break;
+        }
+    }
+    store.x[i] = x;
+    store.y[i] = y;
+    store.xSpeed[i] = vx;
+    store.ySpeed[i] = vy;
+    store.numBounces[i] = bounces;
+}
+
+size_t Simulation::stepEvents(double until) {
+    size_t retired = events.advance(store, until, cfg.bounceLimit);
+    const std::vector<EventEngine::NearBall>& near = events.nearBalls();
+    float r = cfg.ballRadius;
+    for (size_t n = 0; n < near.size(); n++) {
+        if (simTime <= near[n].cooldownEnd) continue;
+        float x, y;
+        events.position(near[n], until, x, y);
+        // Sprawdzamy tylko GrayObs z kolumny piki, tym samym testem co w trybie krokowym
+        const uint32_t* column;
+        size_t count = events.regionObstacles(near[n].region, column);
+        for (size_t c = 0; c < count; c++) {
+            const ObsRect& rect = obsRects[column[c]];
+            if (x + r > rect.x && x - r < rect.x + rect.width && y + r > rect.y && y - r < rect.y + rect.height) {
+                AttachRequest request = { static_cast<uint32_t>(store.indexOf(near[n].ball)), column[c],
+                                          x - rect.x, y - rect.y };
+                attachQueue.push(request);
+                break;
+            }
+        }
+    }
+    for (const AttachRequest* req = attachQueue.begin(); req != attachQueue.end(); ++req) {
+        events.unschedule(store, req->ball, until);
+    }
+    return retired;
+}
+
+// Planuje od biecej chwili wszystkie poruszajce si piki (tryb zdarzeniowy)
+void Simulation::scheduleAll() {
+    if (!cfg.eventDriven) return;
+    events.reset(store.capacity(), cfg.ballRadius, obsRects, 0.25 / BASE_TICK, BASE_TICK, simTime);
+    for (size_t i = 0; i < store.size(); i++) {
+        if (store.active[i] && store.moving[i]) events.schedule(store, i, simTime);
+    }
+}
+
+void Simulation::syncPositions() {
+    if (cfg.eventDriven) {
+        store.compact();
+        events.writeState(store, simTime, simTime - lastDt);
+    }
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        obstacles[k]->placeAttached(store);
+    }
+}
+
+// Przykleja piki zgoszone w tym takcie. Kolejno zgosze zaley od wtkw, wic najpierw
+// porzdkujemy je wedug indeksu piki - lista attachedBalls kadego GrayObs jest wtedy zawsze taka sama.
+size_t Simulation::drainAttachments() {
+    size_t count = attachQueue.size();
+    if (count == 0) return 0;
+    std::sort(attachQueue.begin(), attachQueue.end(), [](const AttachRequest& a, const AttachRequest& b) {
+        return a.ball < b.ball;
+    });
+    for (const AttachRequest* r = attachQueue.begin(); r != attachQueue.end(); ++r) {
+        obstacles[r->obstacle]->attachBall(store, r->ball, r->offsetX, r->offsetY);
+    }
+    attachQueue.clear();
+    return count;
+}
+
+// Jeden wtek na kade BALLS_PER_WORKER piek. Pul zmniejszamy dopiero po SHRINK_DELAY_TICKS
+// taktach mniejszego zapotrzebowania, eby przy wahaniach liczby piek nie tworzy
+// i nie koczy wtkw na zmian.
+static const size_t BALLS_PER_WORKER = 4096;
+static const unsigned SHRINK_DELAY_TICKS = 256;
+
+void Simulation::adjustWorkers() {
+    unsigned wanted = static_cast<unsigned>(std::min<size_t>(store.awakeCount() / BALLS_PER_WORKER + 1, maxWorkers));
+    if (wanted > pool->size()) {
+        pool->resize(wanted);
+        shrinkTicks = 0;
+    } else if (wanted < pool->size()) {
+        if (++shrinkTicks >= SHRINK_DELAY_TICKS) {
+            pool->resize(wanted);
+            shrinkTicks = 0;
+        }
+    } else {
+        shrinkTicks = 0;
+    }
+}
+
+void Simulation::step(float dt) {
+    ScopedLatency timer(HIST_STEP);
+    ScopedTraceEvent event("Simulation::step");
+    if (cfg.adaptiveWorkers && !cfg.eventDriven) adjustWorkers();
+
+    // Prdkoci s wyraone na takt BASE_TICK, pika pokonuje 1/4 prdkoci na takt
+    float scale = dt / BASE_TICK;
+    moveStep = 0.25f * scale;
+    lastDt = dt;
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        obsRects[k] = obstacles[k]->bounds();
+        obsShifts[k] = obstacles[k]->nextShift(scale);
+    }
+    obstacleIndex.update(obsRects, obsShifts);
+    obsRect = obstacleIndex.bounds();
+
+    size_t attachedNow, retiredNow;
+    if (cfg.eventDriven) {
+        retiredNow = stepEvents(simTime + dt);
+        attachedNow = drainAttachments();
+        // Usunite piki zostaj w magazynie do czasu, a bdzie ich co najmniej 1/8,
+        // eby kompaktowanie nie przechodzio przez wszystkie piki w kadym takcie
+        if (store.retiredCount() > 0 && store.retiredCount() * 8 >= store.size()) {
+            ScopedTraceEvent compactEvent("compact");
+            store.compact();
+        }
+        contacts = 0;
+    } else {
+        pool->parallelFor(store.size(), stepChunk, "step balls");
+        for (const uint32_t* i = retireQueue.begin(); i != retireQueue.end(); ++i) {
+            store.retire(*i);
+        }
+        retireQueue.clear();
+        attachedNow = drainAttachments();
+
+        // GrayObs trzymaj uchwyty, wic przesunicie piek ich nie psuje
+        size_t before = store.size();
+        {
+            ScopedTraceEvent compactEvent("compact");
+            store.compact();
+        }
+        retiredNow = before - store.size();
+        contacts = cfg.ballCollisions ? collisions.resolve(store, cfg.ballRadius, *pool) : 0;
+    }
+    MetricsRegistry& m = metrics();
+    m.count(COUNTER_TICKS);
+    m.count(COUNTER_ATTACHED, attachedNow);
+    m.count(COUNTER_BALLS_RETIRED, retiredNow);
+    m.count(COUNTER_CONTACTS, contacts);
+    simTime += dt;
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        obstacles[k]->update(store, rng, scale, simTime, ticks, cfg.eventDriven ? &repelled : nullptr);
+    }
+    // Odepchnite piki ruszaj z pozycji ustawionej przez GrayObs
+    for (size_t n = 0; n < repelled.size(); n++) {
+        size_t i = store.indexOf(repelled[n]);
+        if (i != SIZE_MAX) events.schedule(store, i, simTime);
+    }
+    repelled.clear();
+    ticks++;
+}
+
+void Simulation::snapshot(FrameSnapshot& out) const {
+    out.tick = ticks;
+    out.simTime = simTime;
+    out.x.assign(store.x.begin(), store.x.end());
+    out.y.assign(store.y.begin(), store.y.end());
+    out.prevX.assign(store.prevX.begin(), store.prevX.end());
+    out.prevY.assign(store.prevY.begin(), store.prevY.end());
+    out.radius.assign(store.radius.begin(), store.radius.end());
+    out.colorR.assign(store.colorR.begin(), store.colorR.end());
+    out.colorG.assign(store.colorG.begin(), store.colorG.end());
+    out.colorB.assign(store.colorB.begin(), store.colorB.end());
+    size_t numObs = obstacles.size();
+    out.obstacles.resize(numObs);
+    out.obsColorR.resize(numObs);
+    out.obsColorG.resize(numObs);
+    out.obsColorB.resize(numObs);
+    for (size_t k = 0; k < numObs; k++) {
+        out.obstacles[k] = obstacles[k]->bounds();
+        out.obsColorR[k] = obstacles[k]->colorR;
+        out.obsColorG[k] = obstacles[k]->colorG;
+        out.obsColorB[k] = obstacles[k]->colorB;
+    }
+    out.prevObstacles.assign(obsRects.begin(), obsRects.end());
+    out.attachedCount = attachedCount();
+    out.workers = pool->size();
+    out.workerBusyNs = pool->busyNanoseconds();
+}
+
+// Pola symulacji zapisywane w pliku stanu
+struct SimulationState {
+    int32_t bounceLimit;
+    uint32_t ballCollisions;
+    uint64_t seed;
+    float ballRadius;
+    uint32_t eventState;   // 1, jeli za GrayObs zapisano stan silnika zdarzeniowego
+    uint64_t ballCapacity;
+    uint64_t spawnCount;
+    uint64_t ticks;
+    double simTime;
+    double nextSpawnTime;
+    uint64_t numObstacles;
+};
+
+bool Simulation::saveCheckpoint(const char* path) {
+    // Zapis tylko czyta stan: w trybie zdarzeniowym silnik trafia do pliku razem z magazynem,
+    // wic ani biecy przebieg, ani przebieg po odczycie nie planuje piek od nowa
+    syncPositions();
+    CheckpointWriter out;
+    if (!out.open(path)) return false;
+    SimulationState state;
+    state.bounceLimit = cfg.bounceLimit;
+    state.ballCollisions = cfg.ballCollisions ? 1 : 0;
+    state.seed = rng.seed();
+    state.ballRadius = cfg.ballRadius;
+    state.eventState = cfg.eventDriven ? 1 : 0;
+    state.ballCapacity = store.capacity();
+    state.spawnCount = spawnCount;
+    state.ticks = ticks;
+    state.simTime = simTime;
+    state.nextSpawnTime = nextSpawnTime;
+    state.numObstacles = obstacles.size();
+    out.writeValue("SIMU", state);
+    store.save(out);
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        obstacles[k]->save(out);
+    }
+    if (cfg.eventDriven) events.save(out);
+    return out.close();
+}
+
+bool Simulation::loadCheckpoint(const char* path) {
+    CheckpointReader in;
+    SimulationState state;
+    if (!in.open(path) || !in.readValue("SIMU", state)) return false;
+
+    // Stan jest wczytywany do nowych obiektw i podmieniany dopiero, gdy cay plik jest poprawny
+    CounterRng loadedRng(state.seed);
+    BallStore loadedStore(std::max(static_cast<size_t>(state.ballCapacity), cfg.ballCapacity));
+    if (!loadedStore.load(in)) return false;
+    std::vector<std::unique_ptr<GrayObs>> loadedObstacles;
+    for (uint64_t k = 0; k < state.numObstacles; k++) {
+        loadedObstacles.emplace_back(new GrayObs(static_cast<uint32_t>(k), loadedRng));
+        if (!loadedObstacles.back()->load(in)) return false;
+    }
+    // Stan silnika zdarzeniowego z pliku; bez niego (zapis w trybie krokowym) piki s planowane od chwili zapisu
+    EventEngine loadedEvents;
+    bool haveEvents = cfg.eventDriven && state.eventState != 0;
+    if (haveEvents) {
+        std::vector<ObsRect> rects;
+        for (size_t k = 0; k < loadedObstacles.size(); k++) {
+            rects.push_back(loadedObstacles[k]->bounds());
+        }
+        loadedEvents.reset(loadedStore.capacity(), state.ballRadius, rects, 0.25 / BASE_TICK, BASE_TICK,
+                           state.simTime);
+        if (!loadedEvents.load(in, loadedStore)) return false;
+    }
+
+    cfg.bounceLimit = state.bounceLimit;
+    cfg.ballCollisions = state.ballCollisions != 0;
+    cfg.seed = state.seed;
+    cfg.ballRadius = state.ballRadius;
+    cfg.ballCapacity = loadedStore.capacity();
+    cfg.numObstacles = static_cast<unsigned>(state.numObstacles);
+    rng = loadedRng;
+    store = std::move(loadedStore);
+    obstacles.swap(loadedObstacles);
+    spawnCount = state.spawnCount;
+    ticks = state.ticks;
+    simTime = state.simTime;
+    nextSpawnTime = state.nextSpawnTime;
+    contacts = 0;
+
+    obsRects.clear();
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        obsRects.push_back(obstacles[k]->bounds());
+    }
+    obsShifts.assign(obsRects.size(), 0.0f);
+    attachQueue.reserve(store.capacity());
+    retireQueue.reserve(store.capacity());
+    obstacleIndex.update(obsRects, obsShifts);
+    obsRect = obstacleIndex.bounds();
+    if (cfg.eventDriven) cfg.ballCollisions = false;
+    lastDt = 0.0f;
+    if (haveEvents) {
+        events = std::move(loadedEvents);
+    } else {
+        scheduleAll();
+    }
+    return true;
+}
+
+size_t Simulation::attachedCount() const {
+    size_t count = 0;
+    for (size_t k = 0; k < obstacles.size(); k++) {
+        count += obstacles[k]->attachedBalls.size();
+    }
+    return count;
+}
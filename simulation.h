@@ -0,0 +1,132 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "ball_store.h"
+#include "gray_obs.h"
+#include "ball_collisions.h"
+#include "obstacle_index.h"
+#include "worker_pool.h"
+#include "tick_queue.h"
+#include "event_engine.h"
+#include "frame_snapshot.h"
+
+// Dugo jednego taktu, dla ktrej prdkoci piek i GrayObs zostay dobrane (sekundy)
+const float BASE_TICK = 0.016f;
+
+// Parametry symulacji
+struct SimulationConfig {
+    int bounceLimit;       // Liczba odbi, po ktrej pika znika
+    unsigned numWorkers;   // Liczba wtkw roboczych (przy adaptiveWorkers grna granica), 0 = liczba rdzeni
+    bool adaptiveWorkers;  // Dobiera liczb wtkw do liczby piek
+    unsigned numObstacles; // Liczba GrayObs; pierwszy ma klasyczny ksztat, kolejne s losowe
+    uint64_t seed;         // Ziarno generatora liczb losowych, 0 = losowe
+    bool ballCollisions;   // Czy piki zderzaj si ze sob
+    float ballRadius;      // Promie nowych piek
+    size_t ballCapacity;   // Najwicej piek naraz; pami jest rezerwowana od razu
+    bool eventDriven;      // Silnik zdarzeniowy (event_engine.h) zamiast przesuwania wszystkich piek;
+                           // bez zderze piek, wynik rni si od trybu krokowego zaokrgleniami
+
+    SimulationConfig()
+        : bounceLimit(5), numWorkers(0), adaptiveWorkers(true), numObstacles(1), seed(0), ballCollisions(true), ballRadius(0.1f),
+          ballCapacity(65536), eventDriven(false) {}
+};
+
+// Symulacja piek i GrayObs niezalena od GLUT - stan zmienia si tylko w step().
+// Przy tym samym ziarnie i tej samej sekwencji krokw wynik jest zawsze taki sam.
+class Simulation {
+public:
+    explicit Simulation(const SimulationConfig& config);
+
+    // Przesuwa wiat o dt sekund: piki, przyklejanie, usuwanie nieaktywnych,
+    // zderzenia piek i ruch GrayObs
+    void step(float dt);
+
+    // Metoda dodajca now pik na dole ekranu; INVALID_BALL, gdy osignito ballCapacity
+    BallHandle spawnBall();
+
+    // Dodaje pik w podanym punkcie (rozrzucanie piek w trybie bez okna i w benchmarku)
+    BallHandle spawnBallAt(float x, float y);
+
+    // Harmonogram piek wersji z oknem: dodaje pik, jeli nadesza jej chwila, i planuje nastpn
+    // za 2-10 s czasu symulacji. Odstp zaley tylko od ziarna i numeru piki, a chwila nastpnej piki
+    // jest zapisywana w pliku stanu, wic harmonogram nie zaley od tempa ani od zapisu i odczytu.
+    // Woa przed kadym step().
+    void spawnScheduled();
+
+    // Zapisuje cay stan wiata (piki, GrayObs z przyklejonymi pikami, ziarno, licznik piek, czas)
+    // do pliku; po loadCheckpoint() symulacja biegnie dalej dokadnie tak, jakby nie bya przerwana.
+    // Liczba wtkw, adaptiveWorkers i eventDriven pozostaj z biecej konfiguracji, pojemno magazynu
+    // jest wiksz z zapisanej i biecej. Przy bdzie odczytu stan si nie zmienia.
+    // Zapis nie zmienia przebiegu symulacji. W trybie zdarzeniowym plik zawiera te stan ruchu piek
+    // z silnika zdarzeniowego; plik zapisany w trybie krokowym jest planowany od nowa od chwili zapisu.
+    bool saveCheckpoint(const char* path);
+    bool loadCheckpoint(const char* path);
+
+    // step() nie przesuwa w magazynie piek przyklejonych do GrayObs, a w trybie zdarzeniowym adnych -
+    // pozycje w balls() s aktualizowane dopiero tutaj (w trybie zdarzeniowym razem z usuniciem piek,
+    // ktre znikny). Nie zmienia przebiegu symulacji; woa przed snapshot(), nagrywaniem i odczytem pozycji.
+    void syncPositions();
+
+    // Kopiuje stan potrzebny do rysowania; bufory out s uywane ponownie midzy klatkami
+    void snapshot(FrameSnapshot& out) const;
+
+    const BallStore& balls() const { return store; }
+    size_t numObstacles() const { return obstacles.size(); }
+    const GrayObs& obstacle(size_t k) const { return *obstacles[k]; }
+    size_t attachedCount() const;   // Piki przyklejone do wszystkich GrayObs
+    const SimulationConfig& config() const { return cfg; }
+    const CounterRng& random() const { return rng; }
+    unsigned numWorkers() const { return pool->size(); }
+    ThreadStats threadStats() const { return pool->stats(); }
+    unsigned long long tickCount() const { return ticks; }
+    double time() const { return simTime; }
+    size_t contactCount() const { return contacts; }   // Zderzenia piek w ostatnim takcie
+    unsigned long long eventCount() const { return events.processedEvents(); }   // Obsuone zdarzenia (tryb zdarzeniowy)
+
+private:
+    // Zgoszenie przyklejenia piki z wtku roboczego
+    struct AttachRequest {
+        uint32_t ball;       // Indeks piki w tym takcie
+        uint32_t obstacle;
+        float offsetX, offsetY;
+    };
+
+    void stepBalls(size_t begin, size_t end);
+    void sweepBall(size_t i, int32_t ev);
+    size_t stepEvents(double until);
+    void scheduleAll();
+    double spawnDelay() const;
+    size_t drainAttachments();
+    void adjustWorkers();
+
+    SimulationConfig cfg;
+    CounterRng rng;
+    uint64_t spawnCount;   // Numer nastpnej piki
+    BallStore store;
+    std::vector<std::unique_ptr<GrayObs>> obstacles;
+    std::vector<ObsRect> obsRects;                     // Prostokty GrayObs z pocztku taktu
+    std::vector<float> obsShifts;                      // Przesunicie GrayObs w pionie do koca taktu
+    TickQueue<AttachRequest> attachQueue;              // Co najwyej jedno zgoszenie na pik w takcie
+    TickQueue<uint32_t> retireQueue;                   // Piki, ktre w tym takcie osigny limit odbi
+    ObstacleIndex obstacleIndex;
+    BallCollisions collisions;
+    std::unique_ptr<WorkerPool> pool;
+    unsigned maxWorkers;
+    unsigned shrinkTicks;   // Od ilu taktw pula ma wicej wtkw ni potrzeba
+    WorkerPool::Job stepChunk;
+    ObsRect obsRect;   // Prostokt obejmujcy wszystkie GrayObs - wstpny test w kernelu
+    EventEngine events;
+    std::vector<BallHandle> repelled;   // Piki odepchnite w tym takcie (tryb zdarzeniowy)
+    float lastDt;       // Dugo biecego (w trakcie step()) albo ostatniego taktu w sekundach
+    float moveStep;
+    size_t contacts;
+    unsigned long long ticks;
+    double simTime;
+    double nextSpawnTime;   // Chwila nastpnej piki spawnScheduled()
+};
+
+#endif
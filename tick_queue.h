@@ -0,0 +1,43 @@
+#ifndef TICK_QUEUE_H
+#define TICK_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// Kolejka wielu producentw i jednego konsumenta oprniana raz na takt.
+// Producenci (wtki robocze) rezerwuj miejsce jednym fetch_add i zapisuj element bez blokad.
+// Konsument czyta elementy dopiero po zakoczeniu fazy producentw (WorkerPool::parallelFor
+// czeka na wszystkie wtki), wic elementy nie potrzebuj osobnych znacznikw gotowoci.
+// Pojemno jest staa - push() przy penej kolejce zwraca false.
+template<typename T>
+class TickQueue {
+public:
+    explicit TickQueue(size_t capacity = 0) : items(capacity), tail(0) {}
+
+    // Zmienia pojemno; tylko gdy kolejka jest pusta i nikt do niej nie pisze
+    void reserve(size_t capacity) { items.resize(capacity); }
+
+    bool push(const T& item) {
+        size_t slot = tail.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= items.size()) return false;
+        items[slot] = item;
+        return true;
+    }
+
+    // Elementy zapisane w tym takcie (po zakoczeniu fazy producentw)
+    size_t size() const {
+        size_t n = tail.load(std::memory_order_relaxed);
+        return n < items.size() ? n : items.size();
+    }
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + size(); }
+
+    void clear() { tail.store(0, std::memory_order_relaxed); }
+
+private:
+    std::vector<T> items;
+    std::atomic<size_t> tail;
+};
+
+#endif
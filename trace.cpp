@@ -0,0 +1,465 @@
+#include "trace.h"
+#include "simulation.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t POSITION_BITS = 16;
+static const float POSITION_SCALE = 65536.0f;
+// Najduszy moliwy zapis jednej piki: numer (10 bajtw) + dwie pozycje (po 5) + promie + kolor
+static const size_t MAX_BALL_BYTES = 10 + 5 + 5 + 2 + 3;
+static const size_t MAX_OBSTACLE_BYTES = 4 * 5 + 3;
+
+static int32_t quantize(float v) {
+    return static_cast<int32_t>(lrintf(v * POSITION_SCALE));
+}
+
+static uint8_t colorByte(float c) {
+    return static_cast<uint8_t>(lrintf(std::min(std::max(c, 0.0f), 1.0f) * 255.0f));
+}
+
+// Liczby cakowite ze znakiem s zapisywane jako zigzag + varint (mae wartoci zajmuj mao bajtw)
+static uint8_t* putVarint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+static uint8_t* putSigned(uint8_t* p, int32_t v) {
+    uint32_t zigzag = (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+    return putVarint(p, zigzag);
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool getSigned(const uint8_t*& p, const uint8_t* end, int32_t& v) {
+    uint64_t zigzag;
+    if (!getVarint(p, end, zigzag)) return false;
+    uint32_t u = static_cast<uint32_t>(zigzag);
+    v = static_cast<int32_t>((u >> 1) ^ (0u - (u & 1)));
+    return true;
+}
+
+TraceWriter::TraceWriter()
+    : file(nullptr), head(0), count(0), closing(false), hasPrevious(false), offset(0), failed(false) {}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const char* path, float tickSeconds, uint64_t seed) {
+    file = fopen(path, "wb");
+    if (!file) return false;
+    TraceFileHeader header;
+    memcpy(header.magic, "BBTR", 4);
+    header.version = TRACE_VERSION;
+    header.keyframeInterval = TRACE_KEYFRAME_INTERVAL;
+    header.tickSeconds = tickSeconds;
+    header.seed = seed;
+    header.positionBits = POSITION_BITS;
+    header.reserved = 0;
+    writeBytes(&header, sizeof(header));
+    closing = false;
+    writer = std::thread(&TraceWriter::writerLoop, this);
+    return !failed;
+}
+
+void TraceWriter::record(const Simulation& sim) {
+    if (!file) return;
+    ScopedTraceEvent event("record frame");
+    size_t slot;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCond.wait(lock, [this] { return count < QUEUE_DEPTH; });
+        slot = (head + count) % QUEUE_DEPTH;
+    }
+
+    // Wtek zapisujcy nie dotyka wolnego bufora, wic kopiujemy bez blokady
+    RawFrame& frame = buffers[slot];
+    const BallStore& store = sim.balls();
+    frame.tick = sim.tickCount();
+    frame.simTime = sim.time();
+    frame.attachedCount = sim.attachedCount();
+    frame.serial.assign(store.serial.begin(), store.serial.end());
+    frame.x.assign(store.x.begin(), store.x.end());
+    frame.y.assign(store.y.begin(), store.y.end());
+    frame.radius.assign(store.radius.begin(), store.radius.end());
+    frame.colorR.assign(store.colorR.begin(), store.colorR.end());
+    frame.colorG.assign(store.colorG.begin(), store.colorG.end());
+    frame.colorB.assign(store.colorB.begin(), store.colorB.end());
+    size_t numObs = sim.numObstacles();
+    frame.obstacles.resize(numObs);
+    frame.obsColorR.resize(numObs);
+    frame.obsColorG.resize(numObs);
+    frame.obsColorB.resize(numObs);
+    for (size_t k = 0; k < numObs; k++) {
+        const GrayObs& obs = sim.obstacle(k);
+        frame.obstacles[k] = obs.bounds();
+        frame.obsColorR[k] = obs.colorR;
+        frame.obsColorG[k] = obs.colorG;
+        frame.obsColorB[k] = obs.colorB;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        count++;
+    }
+    queueCond.notify_all();
+}
+
+void TraceWriter::writerLoop() {
+    setTraceThreadName("trace writer");
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCond.wait(lock, [this] { return count > 0 || closing; });
+            if (count == 0) return;
+        }
+
+        RawFrame& frame = buffers[head];
+        bool keyframe = !hasPrevious || index.size() % TRACE_KEYFRAME_INTERVAL == 0 ||
+                        frame.obstacles.size() != previous.obstacles.size();
+        {
+            ScopedTraceEvent event("encode frame");
+            encode(frame, keyframe);
+        }
+        // Bieca klatka staje si odniesieniem dla nastpnej; zamiana wektorw nie kopiuje danych
+        std::swap(frame, previous);
+        hasPrevious = true;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            head = (head + 1) % QUEUE_DEPTH;
+            count--;
+        }
+        queueCond.notify_all();
+    }
+}
+
+void TraceWriter::encode(const RawFrame& frame, bool keyframe) {
+    size_t numBalls = frame.x.size();
+    size_t numObs = frame.obstacles.size();
+    encoded.resize(numBalls * MAX_BALL_BYTES + numObs * MAX_OBSTACLE_BYTES);
+    uint8_t* p = encoded.data();
+
+    // Piki - scalanie z poprzedni klatk po numerze kolejnym
+    size_t j = 0;
+    uint64_t lastSerial = 0;
+    for (size_t i = 0; i < numBalls; i++) {
+        uint64_t serial = frame.serial[i];
+        p = putVarint(p, serial - lastSerial);
+        lastSerial = serial;
+        int32_t qx = quantize(frame.x[i]);
+        int32_t qy = quantize(frame.y[i]);
+        if (!keyframe) {
+            while (j < previous.serial.size() && previous.serial[j] < serial) j++;
+            if (j < previous.serial.size() && previous.serial[j] == serial) {
+                p = putSigned(p, qx - quantize(previous.x[j]));
+                p = putSigned(p, qy - quantize(previous.y[j]));
+                continue;
+            }
+        }
+        p = putSigned(p, qx);
+        p = putSigned(p, qy);
+        uint16_t r = static_cast<uint16_t>(std::min(lrintf(frame.radius[i] * POSITION_SCALE), 65535l));
+        *p++ = static_cast<uint8_t>(r);
+        *p++ = static_cast<uint8_t>(r >> 8);
+        *p++ = colorByte(frame.colorR[i]);
+        *p++ = colorByte(frame.colorG[i]);
+        *p++ = colorByte(frame.colorB[i]);
+    }
+
+    // GrayObs - w klatce rnicowej tylko przesunicie wzgldem poprzedniej klatki
+    for (size_t k = 0; k < numObs; k++) {
+        const ObsRect& rect = frame.obstacles[k];
+        int32_t q[4] = { quantize(rect.x), quantize(rect.y), quantize(rect.width), quantize(rect.height) };
+        if (!keyframe) {
+            const ObsRect& prev = previous.obstacles[k];
+            q[0] -= quantize(prev.x);
+            q[1] -= quantize(prev.y);
+            q[2] -= quantize(prev.width);
+            q[3] -= quantize(prev.height);
+        }
+        for (int c = 0; c < 4; c++) {
+            p = putSigned(p, q[c]);
+        }
+        if (keyframe) {
+            *p++ = colorByte(frame.obsColorR[k]);
+            *p++ = colorByte(frame.obsColorG[k]);
+            *p++ = colorByte(frame.obsColorB[k]);
+        }
+    }
+
+    TraceFrameHeader header;
+    header.type = keyframe ? TRACE_KEYFRAME : TRACE_DELTA;
+    header.payloadBytes = static_cast<uint32_t>(p - encoded.data());
+    header.tick = frame.tick;
+    header.simTime = frame.simTime;
+    header.numBalls = static_cast<uint32_t>(numBalls);
+    header.numObstacles = static_cast<uint32_t>(numObs);
+    header.attachedCount = frame.attachedCount;
+
+    TraceIndexEntry entry = { offset, frame.tick, header.type, header.payloadBytes };
+    index.push_back(entry);
+    writeBytes(&header, sizeof(header));
+    writeBytes(encoded.data(), header.payloadBytes);
+}
+
+void TraceWriter::writeBytes(const void* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, file) != size) failed = true;
+    offset += size;
+}
+
+bool TraceWriter::close() {
+    if (!file) return !failed;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closing = true;
+    }
+    queueCond.notify_all();
+    if (writer.joinable()) writer.join();
+
+    TraceFooter footer;
+    footer.indexOffset = offset;
+    footer.frameCount = index.size();
+    memcpy(footer.magic, "BBIX", 4);
+    footer.version = TRACE_VERSION;
+    if (!index.empty()) writeBytes(index.data(), index.size() * sizeof(TraceIndexEntry));
+    writeBytes(&footer, sizeof(footer));
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+TraceReader::TraceReader() {
+    current.frame = SIZE_MAX;
+    previous.frame = SIZE_MAX;
+}
+
+bool TraceReader::open(const char* path) {
+    index.clear();
+    current.frame = SIZE_MAX;
+    previous.frame = SIZE_MAX;
+    if (!file.open(path)) return false;
+    if (file.size() < sizeof(TraceFileHeader)) return false;
+    memcpy(&fileHeader, file.data(), sizeof(fileHeader));
+    if (memcmp(fileHeader.magic, "BBTR", 4) != 0 || fileHeader.version != TRACE_VERSION ||
+        fileHeader.positionBits != POSITION_BITS) {
+        return false;
+    }
+    return buildIndex();
+}
+
+bool TraceReader::buildIndex() {
+    const uint8_t* data = file.data();
+    size_t size = file.size();
+
+    // Indeks zapisany na kocu pliku
+    if (size >= sizeof(TraceFileHeader) + sizeof(TraceFooter)) {
+        TraceFooter footer;
+        memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        uint64_t indexBytes = footer.frameCount * sizeof(TraceIndexEntry);
+        if (memcmp(footer.magic, "BBIX", 4) == 0 && footer.version == TRACE_VERSION &&
+            footer.frameCount <= size / sizeof(TraceIndexEntry) && footer.indexOffset <= size &&
+            footer.indexOffset + indexBytes + sizeof(footer) == size) {
+            index.resize(static_cast<size_t>(footer.frameCount));
+            if (!index.empty()) memcpy(index.data(), data + footer.indexOffset, indexBytes);
+            // Kada klatka z indeksu musi lee w caoci midzy nagwkiem pliku a indeksem;
+            // uszkodzony indeks odrzucamy i przechodzimy po nagwkach klatek
+            bool valid = !index.empty() && index[0].type == TRACE_KEYFRAME;
+            for (size_t f = 0; valid && f < index.size(); f++) {
+                const TraceIndexEntry& entry = index[f];
+                uint64_t frameBytes = sizeof(TraceFrameHeader) + static_cast<uint64_t>(entry.payloadBytes);
+                valid = entry.type <= TRACE_DELTA && entry.offset >= sizeof(TraceFileHeader) &&
+                        entry.offset <= footer.indexOffset && footer.indexOffset - entry.offset >= frameBytes;
+            }
+            if (valid) return true;
+            index.clear();
+        }
+    }
+
+    // Brak indeksu - przechodzimy po nagwkach klatek, niepena ostatnia klatka jest pomijana
+    uint64_t pos = sizeof(TraceFileHeader);
+    while (pos + sizeof(TraceFrameHeader) <= size) {
+        TraceFrameHeader header;
+        memcpy(&header, data + pos, sizeof(header));
+        if (header.type > TRACE_DELTA || pos + sizeof(header) + header.payloadBytes > size) break;
+        if (index.empty() && header.type != TRACE_KEYFRAME) break;
+        TraceIndexEntry entry = { pos, header.tick, header.type, header.payloadBytes };
+        index.push_back(entry);
+        pos += sizeof(header) + header.payloadBytes;
+    }
+    return !index.empty();
+}
+
+bool TraceReader::decode(size_t frame, const State& ref, State& out) const {
+    const TraceIndexEntry& entry = index[frame];
+    const uint8_t* p = file.data() + entry.offset;
+    memcpy(&out.header, p, sizeof(out.header));
+    // Nagwek klatki musi zgadza si z indeksem, ktry sprawdzi jej granice
+    if (out.header.type != entry.type || out.header.payloadBytes != entry.payloadBytes) return false;
+    p += sizeof(out.header);
+    const uint8_t* end = p + out.header.payloadBytes;
+    bool keyframe = out.header.type == TRACE_KEYFRAME;
+    if (!keyframe && (frame == 0 || ref.frame != frame - 1)) return false;
+    // Pika zajmuje co najmniej 3 bajty (odstp numeru i dwie rnice), GrayObs co najmniej 4 -
+    // liczby z uszkodzonego nagwka nie mog wymusi ogromnych tablic
+    if (3 * static_cast<uint64_t>(out.header.numBalls) + 4 * static_cast<uint64_t>(out.header.numObstacles) >
+        out.header.payloadBytes) {
+        return false;
+    }
+
+    size_t numBalls = out.header.numBalls;
+    out.serial.resize(numBalls);
+    out.x.resize(numBalls);
+    out.y.resize(numBalls);
+    out.radius.resize(numBalls);
+    out.color.resize(3 * numBalls);
+    size_t j = 0;
+    uint64_t serial = 0;
+    for (size_t i = 0; i < numBalls; i++) {
+        uint64_t gap;
+        if (!getVarint(p, end, gap)) return false;
+        serial += gap;
+        out.serial[i] = serial;
+        int32_t qx, qy;
+        if (!getSigned(p, end, qx) || !getSigned(p, end, qy)) return false;
+        if (!keyframe) {
+            while (j < ref.serial.size() && ref.serial[j] < serial) j++;
+            if (j < ref.serial.size() && ref.serial[j] == serial) {
+                out.x[i] = ref.x[j] + qx;
+                out.y[i] = ref.y[j] + qy;
+                out.radius[i] = ref.radius[j];
+                memcpy(&out.color[3 * i], &ref.color[3 * j], 3);
+                continue;
+            }
+        }
+        if (end - p < 5) return false;
+        out.x[i] = qx;
+        out.y[i] = qy;
+        out.radius[i] = static_cast<uint16_t>(p[0] | (p[1] << 8));
+        memcpy(&out.color[3 * i], p + 2, 3);
+        p += 5;
+    }
+
+    size_t numObs = out.header.numObstacles;
+    out.obstacles.resize(4 * numObs);
+    out.obsColor.resize(3 * numObs);
+    if (!keyframe && ref.obstacles.size() != out.obstacles.size()) return false;
+    for (size_t k = 0; k < numObs; k++) {
+        for (int c = 0; c < 4; c++) {
+            int32_t q;
+            if (!getSigned(p, end, q)) return false;
+            out.obstacles[4 * k + c] = keyframe ? q : ref.obstacles[4 * k + c] + q;
+        }
+        if (keyframe) {
+            if (end - p < 3) return false;
+            memcpy(&out.obsColor[3 * k], p, 3);
+            p += 3;
+        } else {
+            memcpy(&out.obsColor[3 * k], &ref.obsColor[3 * k], 3);
+        }
+    }
+    out.frame = frame;
+    return true;
+}
+
+bool TraceReader::read(size_t frame, FrameSnapshot& out) {
+    if (frame >= index.size()) return false;
+
+    if (frame != current.frame) {
+        if (frame == previous.frame) {
+            // Krok wstecz o jedn klatk - poprzedni stan jest ju zdekodowany
+            std::swap(current, previous);
+        } else {
+            size_t key = frame;
+            while (key > 0 && index[key].type != TRACE_KEYFRAME) key--;
+            // Do przodu w obrbie tej samej klatki kluczowej wystarczy dekodowa od biecej klatki
+            size_t start = (current.frame != SIZE_MAX && current.frame < frame && current.frame >= key)
+                               ? current.frame + 1 : key;
+            for (size_t f = start; f <= frame; f++) {
+                if (!decode(f, current, previous)) {
+                    current.frame = SIZE_MAX;
+                    previous.frame = SIZE_MAX;
+                    return false;
+                }
+                std::swap(current, previous);
+            }
+        }
+    }
+    fill(out);
+    return true;
+}
+
+void TraceReader::fill(FrameSnapshot& out) const {
+    const float scale = 1.0f / POSITION_SCALE;
+    size_t numBalls = current.serial.size();
+    out.tick = current.header.tick;
+    out.simTime = current.header.simTime;
+    out.attachedCount = static_cast<size_t>(current.header.attachedCount);
+    out.x.resize(numBalls);
+    out.y.resize(numBalls);
+    out.prevX.resize(numBalls);
+    out.prevY.resize(numBalls);
+    out.radius.resize(numBalls);
+    out.colorR.resize(numBalls);
+    out.colorG.resize(numBalls);
+    out.colorB.resize(numBalls);
+
+    // Poprzednia pozycja tylko wtedy, gdy w pamici jest klatka bezporednio wczeniejsza
+    bool hasPrev = current.frame > 0 && previous.frame == current.frame - 1;
+    size_t j = 0;
+    for (size_t i = 0; i < numBalls; i++) {
+        out.x[i] = current.x[i] * scale;
+        out.y[i] = current.y[i] * scale;
+        out.prevX[i] = out.x[i];
+        out.prevY[i] = out.y[i];
+        if (hasPrev) {
+            while (j < previous.serial.size() && previous.serial[j] < current.serial[i]) j++;
+            if (j < previous.serial.size() && previous.serial[j] == current.serial[i]) {
+                out.prevX[i] = previous.x[j] * scale;
+                out.prevY[i] = previous.y[j] * scale;
+            }
+        }
+        out.radius[i] = current.radius[i] * scale;
+        out.colorR[i] = current.color[3 * i] / 255.0f;
+        out.colorG[i] = current.color[3 * i + 1] / 255.0f;
+        out.colorB[i] = current.color[3 * i + 2] / 255.0f;
+    }
+
+    size_t numObs = current.obstacles.size() / 4;
+    out.obstacles.resize(numObs);
+    out.prevObstacles.resize(numObs);
+    out.obsColorR.resize(numObs);
+    out.obsColorG.resize(numObs);
+    out.obsColorB.resize(numObs);
+    bool hasPrevObs = hasPrev && previous.obstacles.size() == current.obstacles.size();
+    for (size_t k = 0; k < numObs; k++) {
+        const int32_t* q = &current.obstacles[4 * k];
+        ObsRect rect = { q[0] * scale, q[1] * scale, q[2] * scale, q[3] * scale };
+        out.obstacles[k] = rect;
+        if (hasPrevObs) {
+            const int32_t* pq = &previous.obstacles[4 * k];
+            ObsRect prev = { pq[0] * scale, pq[1] * scale, pq[2] * scale, pq[3] * scale };
+            out.prevObstacles[k] = prev;
+        } else {
+            out.prevObstacles[k] = rect;
+        }
+        out.obsColorR[k] = current.obsColor[3 * k] / 255.0f;
+        out.obsColorG[k] = current.obsColor[3 * k + 1] / 255.0f;
+        out.obsColorB[k] = current.obsColor[3 * k + 2] / 255.0f;
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#include "ball_store.h"
+#include "frame_snapshot.h"
+#include "mapped_file.h"
+
+class Simulation;
+
+// Nagranie przebiegu symulacji - binarny plik z klatk na kady takt.
+//
+// Ukad pliku (little-endian):
+//   TraceFileHeader
+//   klatki: TraceFrameHeader + dane klatki
+//   indeks: TraceIndexEntry na klatk, na kocu TraceFooter
+//
+// Klatka kluczowa (co keyframeInterval klatek) zapisuje wszystkie piki w caoci, klatka rnicowa
+// tylko zmiany pozycji wzgldem poprzedniej klatki. Pozycje s kwantowane do 1/65536, wic rnica
+// midzy taktami mieci si zwykle w dwch bajtach. Piki s zapisywane w kolejnoci magazynu,
+// czyli rosncego numeru kolejnego (compact() zachowuje kolejno), i dopasowywane do poprzedniej
+// klatki po tym numerze; pika bez pary jest zapisywana w caoci razem z promieniem i kolorem.
+// Bez indeksu (np. po przerwanym nagraniu) czytelnik odtwarza go, przechodzc kolejno po klatkach.
+
+const uint32_t TRACE_VERSION = 1;
+const uint32_t TRACE_KEYFRAME_INTERVAL = 60;
+
+enum TraceFrameType {
+    TRACE_KEYFRAME = 0,
+    TRACE_DELTA = 1
+};
+
+struct TraceFileHeader {
+    char magic[4];              // "BBTR"
+    uint32_t version;
+    uint32_t keyframeInterval;
+    float tickSeconds;          // Dugo taktu fizyki
+    uint64_t seed;
+    uint32_t positionBits;      // Liczba bitw czci uamkowej skwantowanych pozycji
+    uint32_t reserved;
+};
+
+struct TraceFrameHeader {
+    uint32_t type;              // TraceFrameType
+    uint32_t payloadBytes;      // Rozmiar danych klatki za nagwkiem
+    uint64_t tick;
+    double simTime;
+    uint32_t numBalls;
+    uint32_t numObstacles;
+    uint64_t attachedCount;
+};
+
+struct TraceIndexEntry {
+    uint64_t offset;            // Pooenie nagwka klatki w pliku
+    uint64_t tick;
+    uint32_t type;
+    uint32_t payloadBytes;
+};
+
+struct TraceFooter {
+    uint64_t indexOffset;
+    uint64_t frameCount;
+    char magic[4];              // "BBIX"
+    uint32_t version;
+};
+
+// Zapis nagrania. record() kopiuje stan symulacji do jednego z kilku buforw i wraca od razu;
+// kodowanie i zapis na dysk robi osobny wtek. Gdy wszystkie bufory czekaj na zapis,
+// record() czeka, eby nie zgubi adnego taktu.
+class TraceWriter {
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool open(const char* path, float tickSeconds, uint64_t seed);
+
+    // Dopisuje stan po ostatnim takcie
+    void record(const Simulation& sim);
+
+    // Zapisuje zalege klatki i indeks; false, jeli zapis na dysk si nie powid
+    bool close();
+
+    uint64_t framesWritten() const { return index.size(); }
+    uint64_t bytesWritten() const { return offset; }
+
+private:
+    // Stan wiata skopiowany w record()
+    struct RawFrame {
+        uint64_t tick;
+        double simTime;
+        uint64_t attachedCount;
+        std::vector<uint64_t> serial;
+        std::vector<float> x, y, radius;
+        std::vector<float> colorR, colorG, colorB;
+        std::vector<ObsRect> obstacles;
+        std::vector<float> obsColorR, obsColorG, obsColorB;
+    };
+
+    static const size_t QUEUE_DEPTH = 4;
+
+    void writerLoop();
+    void encode(const RawFrame& frame, bool keyframe);
+    void writeBytes(const void* data, size_t size);
+
+    FILE* file;
+    std::thread writer;
+    std::mutex queueMutex;
+    std::condition_variable queueCond;
+    RawFrame buffers[QUEUE_DEPTH];   // Kolejka cykliczna, producent pisze za ostatnim zajtym
+    size_t head;
+    size_t count;
+    bool closing;
+
+    // Uywane tylko przez wtek zapisujcy
+    RawFrame previous;
+    bool hasPrevious;
+    std::vector<uint8_t> encoded;
+    std::vector<TraceIndexEntry> index;
+    uint64_t offset;
+    bool failed;
+};
+
+// Odczyt nagrania przez mapowanie pliku. read() dekoduje od najbliszej klatki kluczowej,
+// a przy odtwarzaniu do przodu tylko kolejne klatki rnicowe.
+class TraceReader {
+public:
+    TraceReader();
+
+    bool open(const char* path);
+
+    size_t numFrames() const { return index.size(); }
+    const TraceFileHeader& header() const { return fileHeader; }
+    uint64_t tickOf(size_t frame) const { return index[frame].tick; }
+    size_t fileSize() const { return file.size(); }
+
+    // Wypenia out stanem klatki frame; prevX/prevY i prevObstacles to stan z klatki wczeniejszej
+    bool read(size_t frame, FrameSnapshot& out);
+
+private:
+    // Zdekodowany stan jednej klatki w postaci skwantowanej
+    struct State {
+        size_t frame;   // SIZE_MAX, jeli stan jest pusty
+        TraceFrameHeader header;
+        std::vector<uint64_t> serial;
+        std::vector<int32_t> x, y;
+        std::vector<uint16_t> radius;
+        std::vector<uint8_t> color;      // Trzy bajty na pik
+        std::vector<int32_t> obstacles;  // x, y, szeroko, wysoko
+        std::vector<uint8_t> obsColor;
+    };
+
+    bool buildIndex();
+    bool decode(size_t frame, const State& ref, State& out) const;
+    void fill(FrameSnapshot& out) const;
+
+    MappedFile file;
+    TraceFileHeader fileHeader;
+    std::vector<TraceIndexEntry> index;
+    State current, previous;
+};
+
+#endif
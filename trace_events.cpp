@@ -0,0 +1,128 @@
+#include "trace_events.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+std::atomic<bool> traceEventsOn(false);
+
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+static const size_t RING_EVENTS = 1 << 16;   // Na wtek; 1.5 MB, zajmowane przy pierwszym zdarzeniu
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Bufor jednego wtku - pisze tylko waciciel, writeChromeTrace() tylko czyta
+struct TraceEventRing {
+    TraceEventRing() : events(RING_EVENTS), head(0), inUse(true) { name[0] = '\0'; }
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head;   // Liczba zapisanych zdarze od pocztku
+    bool inUse;                   // Naley do dziaajcego wtku; chronione przez ringsMutex
+    char name[32];
+};
+
+static std::mutex ringsMutex;
+static std::vector<std::unique_ptr<TraceEventRing>> rings;
+static thread_local TraceEventRing* localRing = nullptr;
+static thread_local char localName[32] = "";
+
+void enableTraceEvents() {
+    traceEventsOn.store(true, std::memory_order_relaxed);
+}
+
+void setTraceThreadName(const char* name, int index) {
+    if (index >= 0) {
+        snprintf(localName, sizeof(localName), "%s %d", name, index);
+    } else {
+        snprintf(localName, sizeof(localName), "%s", name);
+    }
+    if (localRing) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        memcpy(localRing->name, localName, sizeof(localName));
+    }
+}
+
+void releaseTraceThread() {
+    if (!localRing) return;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    localRing->inUse = false;
+    localRing = nullptr;
+}
+
+// Bufor dla wtku, ktry jeszcze go nie ma: wolny bufor wtku o tej samej nazwie (np. "worker 3"
+// po zmianie rozmiaru puli), inny wolny bufor - wtedy stare zdarzenia s odrzucane, eby nie trafiy
+// pod now nazw - albo dopiero nowy bufor
+static TraceEventRing* acquireRing() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    TraceEventRing* ring = nullptr;
+    for (size_t t = 0; t < rings.size() && !ring; t++) {
+        if (!rings[t]->inUse && strcmp(rings[t]->name, localName) == 0) ring = rings[t].get();
+    }
+    for (size_t t = 0; t < rings.size() && !ring; t++) {
+        if (!rings[t]->inUse) {
+            ring = rings[t].get();
+            ring->head.store(0, std::memory_order_relaxed);
+        }
+    }
+    if (!ring) {
+        rings.emplace_back(new TraceEventRing);
+        ring = rings.back().get();
+    }
+    ring->inUse = true;
+    memcpy(ring->name, localName, sizeof(localName));
+    return ring;
+}
+
+uint64_t traceClockNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count());
+}
+
+void addTraceEvent(const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!localRing) localRing = acquireRing();
+    uint64_t h = localRing->head.load(std::memory_order_relaxed);
+    TraceEvent& e = localRing->events[h % RING_EVENTS];
+    e.name = name;
+    e.start = startNs;
+    e.end = endNs;
+    localRing->head.store(h + 1, std::memory_order_release);
+}
+
+bool writeChromeTrace(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::vector<TraceEvent> copy;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (size_t t = 0; t < rings.size(); t++) {
+        const TraceEventRing& ring = *rings[t];
+        unsigned tid = static_cast<unsigned>(t + 1);
+        char fallback[32];
+        snprintf(fallback, sizeof(fallback), "thread %u", tid);
+        fprintf(out, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",\n", tid, ring.name[0] ? ring.name : fallback);
+        first = false;
+
+        // Wtek moe dalej pisa - zdarzenia nadpisane w trakcie kopiowania s odrzucane
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t from = head > RING_EVENTS ? head - RING_EVENTS : 0;
+        copy.assign(ring.events.begin(), ring.events.end());
+        uint64_t after = ring.head.load(std::memory_order_acquire);
+        if (after > RING_EVENTS && after - RING_EVENTS > from) from = after - RING_EVENTS;
+        for (uint64_t i = from; i < head; i++) {
+            const TraceEvent& e = copy[i % RING_EVENTS];
+            fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    e.name, tid, e.start / 1000.0, (e.end - e.start) / 1000.0);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
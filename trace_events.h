@@ -0,0 +1,51 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Zdarzenia osi czasu w formacie Chrome trace (chrome://tracing, ui.perfetto.dev).
+// Kady wtek zapisuje zdarzenia do wasnego bufora cyklicznego bez blokad; po zapenieniu
+// najstarsze zdarzenia s nadpisywane. Gdy zbieranie jest wyczone, ScopedTraceEvent kosztuje
+// jeden odczyt flagi. Nazwy zdarze musz by staymi napisowymi - zapisywany jest tylko wskanik.
+
+extern std::atomic<bool> traceEventsOn;
+
+inline bool traceEventsEnabled() {
+    return traceEventsOn.load(std::memory_order_relaxed);
+}
+
+void enableTraceEvents();
+
+// Nazwa wtku pokazywana na osi czasu; index >= 0 jest dopisywany do nazwy ("worker 3")
+void setTraceThreadName(const char* name, int index = -1);
+
+// Woane przez koczcy si wtek: jego bufor (z dotychczasowymi zdarzeniami) wraca do puli
+// i dostanie go nastpny nowy wtek, najchtniej o tej samej nazwie - pula wtkw, ktra
+// tworzy i koczy wtki, nie zajmuje przy kadej zmianie rozmiaru nowego bufora
+void releaseTraceThread();
+
+// Nanosekundy od uruchomienia programu
+uint64_t traceClockNs();
+
+void addTraceEvent(const char* name, uint64_t startNs, uint64_t endNs);
+
+// Zapisuje zdarzenia wszystkich wtkw jako JSON; false przy bdzie zapisu
+bool writeChromeTrace(const char* path);
+
+// Zdarzenie obejmujce zasig obiektu
+class ScopedTraceEvent {
+public:
+    explicit ScopedTraceEvent(const char* eventName)
+        : name(eventName), active(traceEventsEnabled()), start(active ? traceClockNs() : 0) {}
+    ~ScopedTraceEvent() {
+        if (active) addTraceEvent(name, start, traceClockNs());
+    }
+
+private:
+    const char* name;
+    bool active;
+    uint64_t start;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Potrjny bufor bez blokad dla jednego producenta i jednego konsumenta.
+// Producent pisze do writeBuffer() i wywouje publish(); konsument wywouje update()
+// i czyta readBuffer(). adna ze stron nigdy nie czeka na drug.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Bufor, ktry wypenia producent
+    T& writeBuffer() { return buffers[back]; }
+
+    // Oddaje wypeniony bufor konsumentowi i bierze w zamian wolny
+    void publish() {
+        unsigned prev = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+    }
+
+    // Przejmuje najnowszy opublikowany bufor; zwraca false, jeli nic nowego nie ma
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        unsigned prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        return true;
+    }
+
+    // Bufor, ktry czyta konsument
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static const unsigned INDEX_MASK = 3;
+    static const unsigned FRESH = 4;
+
+    T buffers[3];
+    std::atomic<unsigned> middle;  // Indeks bufora poredniego + flaga FRESH
+    unsigned back;                 // Uywany tylko przez producenta
+    unsigned front;                // Uywany tylko przez konsumenta
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "uniform_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Najwikszy wymiar siatki w jednej osi - ogranicza pami przy bardzo maych pikach
+static const int MAX_CELLS_PER_AXIS = 1024;
+
+// Piki mog na chwil wystawa poza [-1, 1], siatka obejmuje margines
+static const float WORLD_MARGIN = 0.5f;
+static const float WORLD_EXTENT = 2.0f + 2.0f * WORLD_MARGIN;
+
+UniformGrid::UniformGrid()
+    : invSize(0.0f), origin(-1.0f - WORLD_MARGIN), dimX(0), dimY(0), numCells(0), cursorCapacity(0),
+      cellStart(1, 0) {}
+
+// Przy maej liczbie piek nie ma sensu przechodzi przez setki tysicy pustych komrek -
+// siatka ma najwyej okoo 4 komrek na pik (zaokrglone do potgi dwjki, eby wymiary
+// nie zmieniay si przy kadej nowej pice)
+void UniformGrid::resize(float cellSize, size_t numBalls) {
+    size_t cellBudget = 64;
+    while (cellBudget < 4 * numBalls && cellBudget < static_cast<size_t>(MAX_CELLS_PER_AXIS) * MAX_CELLS_PER_AXIS) {
+        cellBudget *= 2;
+    }
+    int maxDim = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(cellBudget))));
+    int dim = std::max(1, std::min(maxDim, static_cast<int>(WORLD_EXTENT / cellSize)));
+    if (dim == dimX) return;
+
+    dimX = dimY = dim;
+    invSize = dim / WORLD_EXTENT;
+    numCells = static_cast<size_t>(dimX) * dimY;
+    if (numCells > cursorCapacity) {
+        cursor.reset(new std::atomic<uint32_t>[numCells]);
+        cursorCapacity = numCells;
+    }
+    for (size_t c = 0; c < numCells; c++) cursor[c].store(0, std::memory_order_relaxed);
+    cellStart.assign(numCells + 1, 0);
+}
+
+int UniformGrid::cellX(float x) const {
+    int cx = static_cast<int>((x - origin) * invSize);
+    return std::min(std::max(cx, 0), dimX - 1);
+}
+
+int UniformGrid::cellY(float y) const {
+    int cy = static_cast<int>((y - origin) * invSize);
+    return std::min(std::max(cy, 0), dimY - 1);
+}
+
+void UniformGrid::build(const BallStore& store, float cellSize, WorkerPool& pool) {
+    size_t n = store.size();
+    resize(cellSize, n);
+    ballCell.resize(n);
+
+    // 1. Komrka kadej piki i liczno komrek
+    pool.parallelFor(n, [this, &store](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!store.moving[i]) {
+                ballCell[i] = -1;
+                continue;
+            }
+            int32_t c = cellY(store.y[i]) * dimX + cellX(store.x[i]);
+            ballCell[i] = c;
+            cursor[c].fetch_add(1, std::memory_order_relaxed);
+        }
+    }, "grid: count");
+
+    // 2. Suma prefiksowa - pocztek kadej komrki; licznik staje si kursorem zapisu
+    uint32_t total = 0;
+    for (size_t c = 0; c < numCells; c++) {
+        cellStart[c] = total;
+        total += cursor[c].load(std::memory_order_relaxed);
+        cursor[c].store(cellStart[c], std::memory_order_relaxed);
+    }
+    cellStart[numCells] = total;
+    items.resize(total);
+
+    // 3. Rozoenie indeksw piek do komrek
+    pool.parallelFor(n, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            int32_t c = ballCell[i];
+            if (c < 0) continue;
+            items[cursor[c].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(i);
+        }
+    }, "grid: scatter");
+
+    // 4. Kolejno w komrce zaleaa od wtkw - sortujemy, eby wynik by powtarzalny
+    pool.parallelFor(numCells, [this](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            cursor[c].store(0, std::memory_order_relaxed);
+            if (cellStart[c + 1] - cellStart[c] > 1) {
+                std::sort(items.begin() + cellStart[c], items.begin() + cellStart[c + 1]);
+            }
+        }
+    }, "grid: sort");
+}
@@ -0,0 +1,57 @@
+#ifndef UNIFORM_GRID_H
+#define UNIFORM_GRID_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "ball_store.h"
+#include "worker_pool.h"
+
+// Jednorodna siatka przestrzenna do szukania ssiadw piek (faza szeroka kolizji).
+// Budowana od nowa w kadym takcie sortowaniem przez zliczanie, rwnolegle na puli wtkw.
+// Pika trafia do komrki swojego rodka, wic przy boku komrki >= 2 * maksymalny promie
+// wszystkie piki, ktre mog j dotyka, le w ssiedztwie 3x3.
+//
+// Piki s ponumerowane "slotami" w kolejnoci komrek - ssiednie sloty le blisko siebie,
+// wic przechodzenie po slotach zamiast po indeksach piek dobrze korzysta z pamici podrcznej.
+class UniformGrid {
+public:
+    UniformGrid();
+
+    // Przebudowuje siatk dla piek ruchomych (moving != 0)
+    void build(const BallStore& store, float cellSize, WorkerPool& pool);
+
+    int cellsX() const { return dimX; }
+    int cellsY() const { return dimY; }
+
+    // Liczba slotw (piek w siatce) i indeks piki w slocie
+    size_t count() const { return cellStart[numCells]; }
+    uint32_t ball(size_t slot) const { return items[slot]; }
+
+    // Komrka piki w slocie
+    int32_t cellOfSlot(size_t slot) const { return ballCell[items[slot]]; }
+
+    // Zakres slotw komrki (cx, cy); sloty w komrce s uporzdkowane wedug indeksu piki
+    uint32_t cellBegin(int cx, int cy) const { return cellStart[cy * dimX + cx]; }
+    uint32_t cellEnd(int cx, int cy) const { return cellStart[cy * dimX + cx + 1]; }
+
+private:
+    void resize(float cellSize, size_t numBalls);
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    float invSize;
+    float origin;
+    int dimX, dimY;
+    size_t numCells;
+    std::vector<int32_t> ballCell;                    // Komrka kadej piki lub -1
+    std::unique_ptr<std::atomic<uint32_t>[]> cursor;  // Licznik / kursor zapisu kadej komrki
+    size_t cursorCapacity;
+    std::vector<uint32_t> cellStart;                  // numCells + 1 elementw
+    std::vector<uint32_t> items;                      // Indeks piki w kadym slocie
+};
+
+#endif
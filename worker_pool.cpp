@@ -0,0 +1,114 @@
+#include "worker_pool.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <chrono>
+
+WorkerPool::WorkerPool(unsigned numWorkers, unsigned maxWorkers)
+    : barrier(1), job(nullptr), jobName(""), jobCount(0), chunkSize(1), nextChunk(0), busyNs(0),
+      keepWorkers(0), maxThreads(maxWorkers), startedCount(0), retiredCount(0), stopping(false) {
+    if (maxThreads == 0) maxThreads = 2 * std::max(1u, std::thread::hardware_concurrency());
+    resize(numWorkers);
+}
+
+WorkerPool::~WorkerPool() {
+    // Sygna zatrzymania przechodzi przez faz startu jak zwyke zadanie; wtki wypadaj
+    // z bariery w fazie koca, wic po runPhase() pozostaje ju tylko doczenie
+    stopping = true;
+    if (!workers.empty()) runPhase();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void WorkerPool::resize(unsigned numWorkers) {
+    numWorkers = std::min(std::max(numWorkers, 1u), maxThreads);
+    unsigned target = numWorkers - 1;
+    unsigned current = static_cast<unsigned>(workers.size());
+    if (target > current) {
+        // Wtki czekaj na faz startu, ktra nie ruszy bez wtku wywoujcego,
+        // wic nowe wtki mona dopisa do bariery przed ich utworzeniem
+        keepWorkers = target;
+        barrier.addParties(target - current);
+        workers.reserve(target);
+        for (unsigned i = current; i < target; i++) {
+            workers.emplace_back(&WorkerPool::workerLoop, this, i);
+            startedCount++;
+        }
+    } else if (target < current) {
+        // Faza bez zadania - nadmiarowe wtki wypadaj z bariery i kocz si od razu
+        keepWorkers = target;
+        runPhase();
+        for (unsigned i = target; i < current; i++) {
+            workers[i].join();
+            retiredCount++;
+        }
+        workers.resize(target);
+    }
+}
+
+ThreadStats WorkerPool::stats() const {
+    ThreadStats s;
+    s.live = size();
+    s.cap = maxThreads;
+    s.started = startedCount;
+    s.retired = retiredCount;
+    return s;
+}
+
+void WorkerPool::parallelFor(size_t count, const Job& fn, const char* name) {
+    if (count == 0) return;
+    const size_t minChunk = 256;
+    chunkSize = std::max((count + size() * 4 - 1) / (size() * 4), minChunk);
+    chunkSize = (chunkSize + 15) & ~static_cast<size_t>(15);
+    if (workers.empty() || count <= chunkSize) {
+        ScopedTraceEvent event(name);
+        auto start = std::chrono::steady_clock::now();
+        fn(0, count);
+        busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        return;
+    }
+    job = &fn;
+    jobName = name;
+    jobCount = count;
+    nextChunk.store(0, std::memory_order_relaxed);
+    runPhase();
+    job = nullptr;
+}
+
+// Faza startu, praca nad biecym zadaniem (jeli jest) i faza koca
+void WorkerPool::runPhase() {
+    barrier.arriveAndWait();
+    if (job) runChunks();
+    barrier.arriveAndWait();
+}
+
+// Pobiera kolejne porcje a do wyczerpania zakresu
+void WorkerPool::runChunks() {
+    ScopedTraceEvent event(jobName);
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        size_t begin = nextChunk.fetch_add(chunkSize);
+        if (begin >= jobCount) break;
+        (*job)(begin, std::min(begin + chunkSize, jobCount));
+    }
+    busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+}
+
+void WorkerPool::workerLoop(unsigned index) {
+    setTraceThreadName("worker", static_cast<int>(index + 1));
+    for (;;) {
+        barrier.arriveAndWait();
+        if (stopping || index >= keepWorkers) {
+            barrier.arriveAndDrop();
+            releaseTraceThread();
+            return;
+        }
+        if (job) runChunks();
+        barrier.arriveAndWait();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+#include "phase_barrier.h"
+
+// Liczniki wtkw puli
+struct ThreadStats {
+    unsigned live;                 // Wtki dziaajce teraz (razem z wtkiem wywoujcym)
+    unsigned cap;                  // Grny limit liczby wtkw
+    unsigned long long started;    // Wtki utworzone od pocztku
+    unsigned long long retired;    // Wtki zakoczone i doczone (join) od pocztku
+};
+
+// Pula wtkw roboczych przesuwajcych piki porcjami w kadym takcie.
+// Wtki id krok w krok z wtkiem wywoujcym: kade parallelFor to faza startu i faza koca
+// na wsplnej barierze (phase_barrier.h), wic wszystkie wtki kocz faz, zanim zacznie si
+// nastpna, a budzenie kosztuje O(liczba wtkw) na faz niezalenie od liczby piek.
+// Liczb wtkw mona zmienia w trakcie dziaania - nadmiarowe wtki kocz si
+// i s od razu doczane, wic pula nigdy nie trzyma zakoczonych wtkw.
+class WorkerPool {
+public:
+    typedef std::function<void(size_t, size_t)> Job;
+
+    // Wtek wywoujcy parallelFor te liczy, wic tworzymy numWorkers - 1 wtkw.
+    // maxWorkers ogranicza liczb wtkw, 0 = dwa razy liczba rdzeni
+    explicit WorkerPool(unsigned numWorkers, unsigned maxWorkers = 0);
+    ~WorkerPool();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Zmienia liczb wtkw (z ograniczeniem do limitu); woa z tego samego wtku co parallelFor.
+    // Zmniejszenie czeka tylko na zakoczenie bezczynnych wtkw, wic trwa krtko.
+    void resize(unsigned numWorkers);
+
+    ThreadStats stats() const;
+
+    // czny czas pracy wszystkich wtkw (razem z wywoujcym) nad porcjami, od pocztku
+    unsigned long long busyNanoseconds() const { return busyNs.load(std::memory_order_relaxed); }
+
+    // Dzieli zakres [0, count) na porcje, rozdziela je midzy wtki i czeka na zakoczenie.
+    // Porcje s wielokrotnoci 16, eby granice nie rozcinay wektorw kernela.
+    // name opisuje zadanie na osi czasu (trace_events.h) - musi by sta napisow.
+    void parallelFor(size_t count, const Job& fn, const char* name = "parallelFor");
+
+private:
+    void runChunks();
+    void runPhase();
+    void workerLoop(unsigned index);
+
+    std::vector<std::thread> workers;
+    PhaseBarrier barrier;
+    // Pola zadania zapisuje wtek wywoujcy przed faz startu, wtki robocze czytaj je po niej
+    const Job* job;
+    const char* jobName;
+    size_t jobCount;
+    size_t chunkSize;
+    std::atomic<size_t> nextChunk;
+    std::atomic<unsigned long long> busyNs;
+    unsigned keepWorkers;   // Wtki o indeksie >= keepWorkers maj si zakoczy
+    unsigned maxThreads;
+    unsigned long long startedCount;
+    unsigned long long retiredCount;
+    bool stopping;
+};
+
+#endif